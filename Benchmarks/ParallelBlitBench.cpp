@@ -0,0 +1,134 @@
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <algorithm>
+#include <vector>
+
+// Times the full screen blit parallel recording adds every frame, copying the offscreen target the workers draw
+// into onto the swapchain. SDL GPU has no timestamp queries, so the GPU time is taken from fenced submits:
+// a batch of blits against a batch that only clears the destination, divided by the number of blits.
+// Built only when premake is run with --sdl-rendering-benchmarks.
+
+namespace
+{
+    constexpr int Iterations = 20;
+    constexpr int BlitsPerSubmit = 16;
+    constexpr SDL_GPUTextureFormat Format = SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM;
+
+    SDL_GPUTexture* CreateTarget(SDL_GPUDevice* device, Uint32 width, Uint32 height)
+    {
+        SDL_GPUTextureCreateInfo info = {};
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.format = Format;
+        info.width = width;
+        info.height = height;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        info.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        return SDL_CreateGPUTexture(device, &info);
+    }
+
+    void Clear(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* texture)
+    {
+        SDL_GPUColorTargetInfo target = {};
+        target.texture = texture;
+        target.load_op = SDL_GPU_LOADOP_CLEAR;
+        target.store_op = SDL_GPU_STOREOP_STORE;
+        SDL_EndGPURenderPass(SDL_BeginGPURenderPass(commandBuffer, &target, 1, nullptr));
+    }
+
+    // Median milliseconds from submit to the fence signaling, or a negative value if a submit failed
+    double Measure(SDL_GPUDevice* device, SDL_GPUTexture* source, SDL_GPUTexture* destination, Uint32 width, Uint32 height, int blits)
+    {
+        std::vector<double> samples;
+        for (int i = 0; i <= Iterations; i++)
+        {
+            SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+            Clear(commandBuffer, destination);
+            for (int b = 0; b < blits; b++)
+            {
+                SDL_GPUBlitInfo blit = {};
+                blit.source.texture = source;
+                blit.source.w = width;
+                blit.source.h = height;
+                blit.destination.texture = destination;
+                blit.destination.w = width;
+                blit.destination.h = height;
+                blit.load_op = SDL_GPU_LOADOP_DONT_CARE;
+                blit.filter = SDL_GPU_FILTER_NEAREST;
+                SDL_BlitGPUTexture(commandBuffer, &blit);
+            }
+
+            const Uint64 start = SDL_GetPerformanceCounter();
+            SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+            if (fence == nullptr)
+            {
+                return -1.0;
+            }
+            SDL_WaitForGPUFences(device, true, &fence, 1);
+            const Uint64 end = SDL_GetPerformanceCounter();
+            SDL_ReleaseGPUFence(device, fence);
+
+            // The first submit pays for the driver warming up
+            if (i > 0)
+            {
+                samples.push_back(static_cast<double>(end - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()));
+            }
+        }
+
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    SDL_GPUDevice* device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_DXIL | SDL_GPU_SHADERFORMAT_MSL, false, nullptr);
+    if (device == nullptr)
+    {
+        SDL_Log("Failed to create the GPU device: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Log("Driver: %s", SDL_GetGPUDeviceDriver(device));
+    SDL_Log("%-10s %12s %12s %10s", "Size", "Blit ms", "MB/frame", "GB/s");
+
+    const Uint32 sizes[][2] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+    for (const auto& size : sizes)
+    {
+        const Uint32 width = size[0];
+        const Uint32 height = size[1];
+        SDL_GPUTexture* source = CreateTarget(device, width, height);
+        SDL_GPUTexture* destination = CreateTarget(device, width, height);
+        if (source == nullptr || destination == nullptr)
+        {
+            SDL_Log("%ux%u: failed to create the targets: %s", width, height, SDL_GetError());
+            SDL_ReleaseGPUTexture(device, source);
+            SDL_ReleaseGPUTexture(device, destination);
+            SDL_DestroyGPUDevice(device);
+            return 1;
+        }
+
+        const double baselineMs = Measure(device, source, destination, width, height, 0);
+        const double blitMs = Measure(device, source, destination, width, height, BlitsPerSubmit);
+        SDL_ReleaseGPUTexture(device, source);
+        SDL_ReleaseGPUTexture(device, destination);
+        if (baselineMs < 0.0 || blitMs < 0.0)
+        {
+            SDL_Log("%ux%u: submit failed: %s", width, height, SDL_GetError());
+            SDL_DestroyGPUDevice(device);
+            return 1;
+        }
+
+        // Every blit reads the source and writes the destination once, the same bytes SDLFrameStats::BlitBytes reports
+        const double perBlitMs = SDL_max(blitMs - baselineMs, 0.0) / BlitsPerSubmit;
+        const double bytes = 2.0 * width * height * SDL_GPUTextureFormatTexelBlockSize(Format);
+        const double gigabytesPerSecond = perBlitMs > 0.0 ? bytes / (perBlitMs / 1000.0) / 1e9 : 0.0;
+        SDL_Log("%5ux%-4u %12.4f %12.2f %10.2f", width, height, perBlitMs, bytes / (1024.0 * 1024.0), gigabytesPerSecond);
+    }
+
+    SDL_DestroyGPUDevice(device);
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "SDLBufferPool.h"
+#include "SDLShader.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    // Smaller buffers aren't worth a class of their own
+    static constexpr Uint32 MinBufferSizeClass = 256;
+
+    // Free buffers that haven't been reused for this many frames are destroyed
+    static constexpr Uint64 MaxIdleFrames = 300;
+
+    SDLBufferPool::~SDLBufferPool()
+    {
+        Clear();
+    }
+
+    void SDLBufferPool::Initialize(SDL_GPUDevice* device)
+    {
+        Clear();
+        _device = device;
+    }
+
+    void SDLBufferPool::BeginFrame(Uint64 frame, Uint64 completedFrame)
+    {
+        _frame = frame;
+
+        while (!_retiredBuffers.empty() && _retiredBuffers.front().Frame <= completedFrame)
+        {
+            const SDLPooledBuffer& retired = _retiredBuffers.front().Buffer;
+            FreeBuffer freeBuffer = {};
+            freeBuffer.Buffer = retired.Buffer;
+            freeBuffer.FreedFrame = frame;
+            _freeBuffers[GetClassKey(retired.Usage, retired.Size)].push_back(freeBuffer);
+            _retiredBuffers.pop_front();
+        }
+
+        for (auto& [classKey, freeBuffers] : _freeBuffers)
+        {
+            const auto size = static_cast<Uint32>(classKey);
+            std::erase_if(freeBuffers, [this, frame, size](const FreeBuffer& freeBuffer)
+            {
+                if (freeBuffer.FreedFrame + MaxIdleFrames > frame)
+                {
+                    return false;
+                }
+
+                SDL_ReleaseGPUBuffer(_device, freeBuffer.Buffer);
+                _pooledBytes -= size;
+                return true;
+            });
+        }
+    }
+
+    SDLPooledBuffer SDLBufferPool::Acquire(SDL_GPUBufferUsageFlags usage, Uint32 size)
+    {
+        SDLPooledBuffer pooledBuffer = {};
+        pooledBuffer.Size = SDLGetBufferSizeClass(size);
+        pooledBuffer.Usage = usage;
+
+        // Take the most recently freed buffer, the idle ones at the front are left to be trimmed
+        auto i = _freeBuffers.find(GetClassKey(usage, pooledBuffer.Size));
+        if (i != _freeBuffers.end() && !i->second.empty())
+        {
+            pooledBuffer.Buffer = i->second.back().Buffer;
+            i->second.pop_back();
+            _pooledBytes -= pooledBuffer.Size;
+            _reusedCount++;
+            return pooledBuffer;
+        }
+
+        SDL_GPUBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.size = pooledBuffer.Size;
+        bufferCreateInfo.usage = usage;
+        pooledBuffer.Buffer = SDLCreateBuffer(bufferCreateInfo, _device);
+        if (pooledBuffer.Buffer == nullptr)
+        {
+            TBX_ASSERT(false, "Failed to create buffer: {}", SDL_GetError());
+            return {};
+        }
+
+        _createdCount++;
+        return pooledBuffer;
+    }
+
+    void SDLBufferPool::Release(const SDLPooledBuffer& buffer)
+    {
+        if (buffer.Buffer == nullptr)
+        {
+            return;
+        }
+
+        RetiredBuffer retired = {};
+        retired.Frame = _frame;
+        retired.Buffer = buffer;
+        _retiredBuffers.push_back(retired);
+        _pooledBytes += buffer.Size;
+    }
+
+    void SDLBufferPool::Clear()
+    {
+        if (_device != nullptr)
+        {
+            for (const auto& [classKey, freeBuffers] : _freeBuffers)
+            {
+                for (const auto& freeBuffer : freeBuffers)
+                {
+                    SDL_ReleaseGPUBuffer(_device, freeBuffer.Buffer);
+                }
+            }
+            for (const auto& retired : _retiredBuffers)
+            {
+                SDL_ReleaseGPUBuffer(_device, retired.Buffer.Buffer);
+            }
+        }
+        _freeBuffers.clear();
+        _retiredBuffers.clear();
+        _pooledBytes = 0;
+    }
+
+    Uint64 SDLBufferPool::GetClassKey(SDL_GPUBufferUsageFlags usage, Uint32 size)
+    {
+        return (static_cast<Uint64>(usage) << 32) | size;
+    }
+
+    Uint32 SDLGetBufferSizeClass(Uint32 size)
+    {
+        Uint32 sizeClass = MinBufferSizeClass;
+        while (sizeClass < size && sizeClass < 0x80000000u)
+        {
+            sizeClass <<= 1;
+        }
+        return SDL_max(sizeClass, size);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace SDLRendering
+{
+    struct SDLPooledBuffer
+    {
+        SDL_GPUBuffer* Buffer = nullptr;
+        // Capacity of the buffer, the size class it was allocated from
+        Uint32 Size = 0;
+        SDL_GPUBufferUsageFlags Usage = 0;
+    };
+
+    // Recycles GPU buffers instead of creating and destroying driver objects for dynamic data.
+    // Buffers come in power of two size classes per usage, released buffers are parked until the frame that
+    // released them has completed and then handed out again. Free buffers nobody asked for in a while are destroyed.
+    struct SDLBufferPool
+    {
+    public:
+        ~SDLBufferPool();
+
+        void Initialize(SDL_GPUDevice* device);
+
+        // Returns buffers released at or before completedFrame to the pool, buffers released from now on belong to frame
+        void BeginFrame(Uint64 frame, Uint64 completedFrame);
+
+        // Returns a buffer of at least size bytes with the given usage, reusing a free one of the same class if there is one
+        SDLPooledBuffer Acquire(SDL_GPUBufferUsageFlags usage, Uint32 size);
+        void Release(const SDLPooledBuffer& buffer);
+
+        Uint64 GetCreatedCount() const { return _createdCount; }
+        Uint64 GetReusedCount() const { return _reusedCount; }
+
+        // Bytes held by free buffers and buffers waiting for their frame to complete
+        Uint64 GetPooledBytes() const { return _pooledBytes; }
+
+        // Destroys every buffer the pool holds, only safe once the GPU is idle
+        void Clear();
+
+    private:
+        struct FreeBuffer
+        {
+            SDL_GPUBuffer* Buffer = nullptr;
+            Uint64 FreedFrame = 0;
+        };
+
+        struct RetiredBuffer
+        {
+            Uint64 Frame = 0;
+            SDLPooledBuffer Buffer = {};
+        };
+
+        static Uint64 GetClassKey(SDL_GPUBufferUsageFlags usage, Uint32 size);
+
+        std::unordered_map<Uint64, std::vector<FreeBuffer>> _freeBuffers = {};
+        std::deque<RetiredBuffer> _retiredBuffers = {};
+        SDL_GPUDevice* _device = nullptr;
+        Uint64 _frame = 1;
+        Uint64 _createdCount = 0;
+        Uint64 _reusedCount = 0;
+        Uint64 _pooledBytes = 0;
+    };
+
+    // The smallest size class that holds size bytes
+    Uint32 SDLGetBufferSizeClass(Uint32 size);
+}
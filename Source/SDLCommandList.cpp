@@ -0,0 +1,245 @@
+#include "SDLCommandList.h"
+#include "SDLPipeline.h"
+#include <Tbx/Graphics/Material.h>
+#include <Tbx/Graphics/Mesh.h>
+
+namespace SDLRendering
+{
+    bool SDLCommandList::Translate(const Tbx::FrameBuffer& buffer)
+    {
+        // An unchanged frame is walked once, a changed one only up to its first difference before it is translated
+        if (_version != 0 && Matches(buffer))
+        {
+            return false;
+        }
+
+        // Containers are cleared rather than released so their capacity carries over between frames
+        _commands.clear();
+        _materials.clear();
+        _meshes.clear();
+        _textures.clear();
+        _uniforms.clear();
+        _clearColors.clear();
+        _uniformBytes.clear();
+        _materialHandles.clear();
+        _meshHandles.clear();
+
+        for (const auto& cmd : buffer.GetCommands())
+        {
+            SDLCommand command = {};
+            switch (cmd.GetType())
+            {
+                case Tbx::DrawCommandType::Clear:
+                {
+                    const auto& color = std::any_cast<const Tbx::Color&>(cmd.GetPayload());
+                    command.Type = SDLCommandType::Clear;
+                    command.Handle = static_cast<Uint32>(_clearColors.size());
+                    _clearColors.push_back({ color.R, color.G, color.B, color.A });
+                    break;
+                }
+                case Tbx::DrawCommandType::CompileMaterial:
+                {
+                    command.Type = SDLCommandType::CompileMaterial;
+                    command.Handle = InternMaterial(std::any_cast<const Tbx::Material&>(cmd.GetPayload()));
+                    break;
+                }
+                case Tbx::DrawCommandType::SetMaterial:
+                {
+                    command.Type = SDLCommandType::SetMaterial;
+                    command.Handle = InternMaterial(std::any_cast<const Tbx::Material&>(cmd.GetPayload()));
+                    break;
+                }
+                case Tbx::DrawCommandType::UploadMaterialData:
+                {
+                    const auto& data = std::any_cast<const Tbx::ShaderData&>(cmd.GetPayload());
+                    const auto* bytes = static_cast<const Uint8*>(static_cast<const void*>(data.UniformData));
+
+                    SDLUniformHandle uniform = {};
+                    uniform.Offset = static_cast<Uint32>(_uniformBytes.size());
+                    uniform.Size = static_cast<Uint32>(data.UniformSize);
+                    uniform.Slot = static_cast<Uint32>(data.UniformSlot);
+                    uniform.IsFragment = data.IsFragment;
+                    _uniformBytes.insert(_uniformBytes.end(), bytes, bytes + data.UniformSize);
+
+                    command.Type = SDLCommandType::UploadUniform;
+                    command.Handle = static_cast<Uint32>(_uniforms.size());
+                    _uniforms.push_back(uniform);
+                    break;
+                }
+                case Tbx::DrawCommandType::DrawMesh:
+                {
+                    command.Type = SDLCommandType::DrawMesh;
+                    command.Handle = InternMesh(std::any_cast<const Tbx::Mesh&>(cmd.GetPayload()));
+                    break;
+                }
+                default:
+                    continue;
+            }
+            _commands.push_back(command);
+        }
+
+        _version++;
+        return true;
+    }
+
+    void SDLCommandList::Clear()
+    {
+        _commands.clear();
+        _materials.clear();
+        _meshes.clear();
+        _layouts.clear();
+        _textures.clear();
+        _uniforms.clear();
+        _clearColors.clear();
+        _uniformBytes.clear();
+        _materialHandles.clear();
+        _meshHandles.clear();
+        _layoutHandles.clear();
+        _version = 0;
+    }
+
+    bool SDLCommandList::Matches(const Tbx::FrameBuffer& buffer) const
+    {
+        size_t next = 0;
+        for (const auto& cmd : buffer.GetCommands())
+        {
+            // Commands Translate skips have no counterpart in the list
+            const auto type = cmd.GetType();
+            if (type != Tbx::DrawCommandType::Clear &&
+                type != Tbx::DrawCommandType::CompileMaterial &&
+                type != Tbx::DrawCommandType::SetMaterial &&
+                type != Tbx::DrawCommandType::UploadMaterialData &&
+                type != Tbx::DrawCommandType::DrawMesh)
+            {
+                continue;
+            }
+            if (next == _commands.size())
+            {
+                return false;
+            }
+
+            const SDLCommand& command = _commands[next++];
+            switch (type)
+            {
+                case Tbx::DrawCommandType::Clear:
+                {
+                    if (command.Type != SDLCommandType::Clear)
+                    {
+                        return false;
+                    }
+
+                    const auto& color = std::any_cast<const Tbx::Color&>(cmd.GetPayload());
+                    const SDL_FColor& clearColor = _clearColors[command.Handle];
+                    if (clearColor.r != color.R || clearColor.g != color.G || clearColor.b != color.B || clearColor.a != color.A)
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                case Tbx::DrawCommandType::CompileMaterial:
+                case Tbx::DrawCommandType::SetMaterial:
+                {
+                    const auto expectedType = type == Tbx::DrawCommandType::CompileMaterial ? SDLCommandType::CompileMaterial : SDLCommandType::SetMaterial;
+                    const auto& material = std::any_cast<const Tbx::Material&>(cmd.GetPayload());
+                    if (command.Type != expectedType || _materials[command.Handle].Id != material.GetId())
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                case Tbx::DrawCommandType::UploadMaterialData:
+                {
+                    const auto& data = std::any_cast<const Tbx::ShaderData&>(cmd.GetPayload());
+                    if (command.Type != SDLCommandType::UploadUniform)
+                    {
+                        return false;
+                    }
+
+                    const SDLUniformHandle& uniform = _uniforms[command.Handle];
+                    if (uniform.Size != static_cast<Uint32>(data.UniformSize) ||
+                        uniform.Slot != static_cast<Uint32>(data.UniformSlot) ||
+                        uniform.IsFragment != data.IsFragment ||
+                        SDL_memcmp(GetUniformData(uniform), static_cast<const void*>(data.UniformData), uniform.Size) != 0)
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                case Tbx::DrawCommandType::DrawMesh:
+                {
+                    const auto& mesh = std::any_cast<const Tbx::Mesh&>(cmd.GetPayload());
+                    if (command.Type != SDLCommandType::DrawMesh || _meshes[command.Handle].Id != mesh.GetId())
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        return next == _commands.size();
+    }
+
+    Uint32 SDLCommandList::InternMaterial(const Tbx::Material& material)
+    {
+        const auto i = _materialHandles.find(material.GetId());
+        if (i != _materialHandles.end())
+        {
+            return i->second;
+        }
+
+        SDLMaterialHandle handle = {};
+        handle.Id = material.GetId();
+        handle.VertexShader = material.GetVertexShader();
+        handle.FragmentShader = material.GetFragmentShader();
+        handle.FirstTexture = static_cast<Uint32>(_textures.size());
+        for (const auto& texture : material.GetTextures())
+        {
+            _textures.push_back(texture.GetId());
+        }
+        handle.TextureCount = static_cast<Uint32>(_textures.size()) - handle.FirstTexture;
+
+        const auto index = static_cast<Uint32>(_materials.size());
+        _materials.push_back(handle);
+        _materialHandles.emplace(handle.Id, index);
+        return index;
+    }
+
+    Uint32 SDLCommandList::InternMesh(const Tbx::Mesh& mesh)
+    {
+        const auto i = _meshHandles.find(mesh.GetId());
+        if (i != _meshHandles.end())
+        {
+            return i->second;
+        }
+
+        SDLMeshHandle handle = {};
+        handle.Id = mesh.GetId();
+        handle.Layout = InternLayout(mesh.GetVertexBuffer().GetLayout());
+
+        const auto index = static_cast<Uint32>(_meshes.size());
+        _meshes.push_back(handle);
+        _meshHandles.emplace(handle.Id, index);
+        return index;
+    }
+
+    Uint32 SDLCommandList::InternLayout(const Tbx::BufferLayout& layout)
+    {
+        // Meshes sharing a vertex layout share one copy of it
+        const Uint64 hash = SDLHashBufferLayout(layout);
+        const auto [first, last] = _layoutHandles.equal_range(hash);
+        for (auto i = first; i != last; ++i)
+        {
+            if (SDLBufferLayoutsEqual(_layouts[i->second], layout))
+            {
+                return i->second;
+            }
+        }
+
+        const auto index = static_cast<Uint32>(_layouts.size());
+        _layouts.push_back(layout);
+        _layoutHandles.emplace(hash, index);
+        return index;
+    }
+}
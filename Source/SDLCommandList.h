@@ -0,0 +1,102 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <vector>
+#include <Tbx/Graphics/IRenderer.h>
+#include <Tbx/Graphics/Buffers.h>
+
+namespace SDLRendering
+{
+    enum class SDLCommandType : Uint8
+    {
+        Clear,
+        CompileMaterial,
+        SetMaterial,
+        UploadUniform,
+        DrawMesh
+    };
+
+    // A lowered frame buffer command, the handle indexes the table matching its type
+    struct SDLCommand
+    {
+        SDLCommandType Type = SDLCommandType::Clear;
+        Uint32 Handle = 0;
+    };
+
+    struct SDLMaterialHandle
+    {
+        Tbx::Uid Id;
+        Tbx::Uid VertexShader;
+        Tbx::Uid FragmentShader;
+
+        // Range into SDLCommandList::GetTextures()
+        Uint32 FirstTexture = 0;
+        Uint32 TextureCount = 0;
+    };
+
+    struct SDLMeshHandle
+    {
+        Tbx::Uid Id;
+
+        // Index into SDLCommandList::GetLayouts(), the same layout keeps its index for the list's lifetime
+        Uint32 Layout = 0;
+    };
+
+    struct SDLUniformHandle
+    {
+        // Range into SDLCommandList::GetUniformBytes()
+        Uint32 Offset = 0;
+        Uint32 Size = 0;
+        Uint32 Slot = 0;
+        bool IsFragment = false;
+    };
+
+    // A flat, type erasure free translation of a Tbx::FrameBuffer.
+    // Materials, meshes and textures are interned into tables so the commands only carry small handles,
+    // and uniform bytes are copied once into a single arena. Vertex layouts outlive translations, so their
+    // indices can key pipelines across frames.
+    struct SDLCommandList
+    {
+    public:
+        // Lowers the frame buffer, returns false if it matched the last translation and the list was reused as is
+        bool Translate(const Tbx::FrameBuffer& buffer);
+
+        const std::vector<SDLCommand>& GetCommands() const { return _commands; }
+        const std::vector<SDLMaterialHandle>& GetMaterials() const { return _materials; }
+        const std::vector<SDLMeshHandle>& GetMeshes() const { return _meshes; }
+        const std::vector<Tbx::BufferLayout>& GetLayouts() const { return _layouts; }
+        const std::vector<Tbx::Uid>& GetTextures() const { return _textures; }
+        const std::vector<SDLUniformHandle>& GetUniforms() const { return _uniforms; }
+        const std::vector<SDL_FColor>& GetClearColors() const { return _clearColors; }
+        const Uint8* GetUniformData(const SDLUniformHandle& uniform) const { return _uniformBytes.data() + uniform.Offset; }
+
+        // Bumped every time the list is rebuilt, so stages derived from it know when to rebuild too
+        Uint64 GetVersion() const { return _version; }
+
+        // Also forgets the layouts, so pipelines keyed by layout index have to be dropped along with it
+        void Clear();
+
+    private:
+        // Compares the frame buffer against the translated commands, stops at the first difference
+        bool Matches(const Tbx::FrameBuffer& buffer) const;
+        Uint32 InternMaterial(const Tbx::Material& material);
+        Uint32 InternMesh(const Tbx::Mesh& mesh);
+        Uint32 InternLayout(const Tbx::BufferLayout& layout);
+
+        std::vector<SDLCommand> _commands = {};
+        std::vector<SDLMaterialHandle> _materials = {};
+        std::vector<SDLMeshHandle> _meshes = {};
+        std::vector<Tbx::BufferLayout> _layouts = {};
+        std::vector<Tbx::Uid> _textures = {};
+        std::vector<SDLUniformHandle> _uniforms = {};
+        std::vector<SDL_FColor> _clearColors = {};
+        std::vector<Uint8> _uniformBytes = {};
+
+        std::unordered_map<Tbx::Uid, Uint32> _materialHandles = {};
+        std::unordered_map<Tbx::Uid, Uint32> _meshHandles = {};
+        // Layouts with the same hash are told apart by comparing them
+        std::unordered_multimap<Uint64, Uint32> _layoutHandles = {};
+
+        Uint64 _version = 0;
+    };
+}
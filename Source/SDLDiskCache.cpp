@@ -0,0 +1,141 @@
+#include "SDLDiskCache.h"
+#include "SDLHash.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    static constexpr Uint32 DiskCacheFormatVersion = 2;
+
+    struct SDLDiskCacheHeader
+    {
+        Uint32 Magic = 0;
+        Uint32 FormatVersion = DiskCacheFormatVersion;
+        Uint32 Version = 0;
+        Uint32 MetadataSize = 0;
+        Uint64 Checksum = 0;
+        Uint64 Key = 0;
+        Uint64 Size = 0;
+    };
+
+    SDLDiskCache::SDLDiskCache(const char* name, const char* extension, Uint32 magic, Uint32 version)
+    {
+        _name = name;
+        _extension = extension;
+        _magic = magic;
+        _version = version;
+    }
+
+    void SDLDiskCache::SetDirectory(const std::string& directory)
+    {
+        _directory = directory;
+        if (_directory.empty())
+        {
+            return;
+        }
+
+        if (_directory.back() != '/' && _directory.back() != '\\')
+        {
+            _directory += '/';
+        }
+
+        if (!SDL_CreateDirectory(_directory.c_str()))
+        {
+            TBX_TRACE_WARN("Failed to create {} cache directory {}: {}", _name, _directory, SDL_GetError());
+            _directory.clear();
+        }
+    }
+
+    bool SDLDiskCache::Load(Uint64 key, std::vector<Uint8>& payload, void* metadata, size_t metadataSize) const
+    {
+        if (_directory.empty())
+        {
+            return false;
+        }
+
+        const std::string path = GetPath(key);
+        size_t fileSize = 0;
+        void* fileData = SDL_LoadFile(path.c_str(), &fileSize);
+        if (fileData == nullptr)
+        {
+            return false;
+        }
+
+        SDLDiskCacheHeader header = {};
+        bool valid = fileSize >= sizeof(header) + metadataSize;
+        if (valid)
+        {
+            SDL_memcpy(&header, fileData, sizeof(header));
+            const auto* entryMetadata = static_cast<const Uint8*>(fileData) + sizeof(header);
+            const auto* entryPayload = entryMetadata + metadataSize;
+            valid = header.Magic == _magic &&
+                header.FormatVersion == DiskCacheFormatVersion &&
+                header.Version == _version &&
+                header.MetadataSize == metadataSize &&
+                header.Key == key &&
+                header.Size == fileSize - sizeof(header) - metadataSize &&
+                header.Checksum == SDLHashBytes(entryMetadata, metadataSize + static_cast<size_t>(header.Size));
+            if (valid)
+            {
+                if (metadataSize > 0)
+                {
+                    SDL_memcpy(metadata, entryMetadata, metadataSize);
+                }
+                payload.assign(entryPayload, entryPayload + header.Size);
+            }
+        }
+        SDL_free(fileData);
+
+        if (!valid)
+        {
+            // Stale or corrupt, drop it so it gets rebuilt
+            TBX_TRACE_WARN("Discarding invalid {} cache entry {}", _name, path);
+            SDL_RemovePath(path.c_str());
+        }
+        return valid;
+    }
+
+    void SDLDiskCache::Store(Uint64 key, const void* payload, size_t size, const void* metadata, size_t metadataSize) const
+    {
+        if (_directory.empty())
+        {
+            return;
+        }
+
+        SDLDiskCacheHeader header = {};
+        header.Magic = _magic;
+        header.Version = _version;
+        header.MetadataSize = static_cast<Uint32>(metadataSize);
+        header.Checksum = SDLHashBytes(payload, size, SDLHashBytes(metadata, metadataSize));
+        header.Key = key;
+        header.Size = size;
+
+        // Write to a temporary file first so a crash never leaves a half written entry behind
+        const std::string path = GetPath(key);
+        const std::string tempPath = path + ".tmp";
+        SDL_IOStream* file = SDL_IOFromFile(tempPath.c_str(), "wb");
+        if (file == nullptr)
+        {
+            TBX_TRACE_WARN("Failed to write {} cache entry {}: {}", _name, path, SDL_GetError());
+            return;
+        }
+
+        const bool written =
+            SDL_WriteIO(file, &header, sizeof(header)) == sizeof(header) &&
+            (metadataSize == 0 || SDL_WriteIO(file, metadata, metadataSize) == metadataSize) &&
+            SDL_WriteIO(file, payload, size) == size;
+        SDL_CloseIO(file);
+
+        if (!written || !SDL_RenamePath(tempPath.c_str(), path.c_str()))
+        {
+            TBX_TRACE_WARN("Failed to write {} cache entry {}: {}", _name, path, SDL_GetError());
+            SDL_RemovePath(tempPath.c_str());
+        }
+    }
+
+    std::string SDLDiskCache::GetPath(Uint64 key) const
+    {
+        char name[32] = {};
+        SDL_snprintf(name, sizeof(name), "%016llx%s", static_cast<unsigned long long>(key), _extension);
+        return _directory + name;
+    }
+}
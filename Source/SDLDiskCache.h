@@ -0,0 +1,34 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+
+namespace SDLRendering
+{
+    // Persists blobs between runs, one file per key in the cache directory.
+    // Entries carry a header with the key, the producer's version, a checksum of the payload and a small block of
+    // metadata the owner describes the payload with. Anything that doesn't match is treated as a miss and removed.
+    // Holds no state besides the directory, so loads and stores may run on several threads at once.
+    struct SDLDiskCache
+    {
+    public:
+        // The magic tells the owners' files apart, version is bumped whenever the owner's output changes
+        SDLDiskCache(const char* name, const char* extension, Uint32 magic, Uint32 version);
+
+        void SetDirectory(const std::string& directory);
+        const std::string& GetDirectory() const { return _directory; }
+
+        // metadataSize has to match what the entry was stored with, the metadata is copied into metadata
+        bool Load(Uint64 key, std::vector<Uint8>& payload, void* metadata = nullptr, size_t metadataSize = 0) const;
+        void Store(Uint64 key, const void* payload, size_t size, const void* metadata = nullptr, size_t metadataSize = 0) const;
+
+    private:
+        std::string GetPath(Uint64 key) const;
+
+        std::string _directory = "";
+        const char* _name = "";
+        const char* _extension = "";
+        Uint32 _magic = 0;
+        Uint32 _version = 0;
+    };
+}
@@ -0,0 +1,235 @@
+#include "SDLDrawSort.h"
+#include "SDLPipeline.h"
+#include "SDLUniforms.h"
+#include <Tbx/Debug/Debugging.h>
+#include <algorithm>
+
+namespace SDLRendering
+{
+    static constexpr Uint64 FieldMask = 0xFFF;
+    static constexpr Uint32 SegmentMask = 0xFFFF;
+
+    static Uint64 MakeSortKey(Uint32 segment, Uint32 pipeline, Uint32 material, Uint32 textureSet, Uint32 depth)
+    {
+        return (static_cast<Uint64>(segment & SegmentMask) << 48) |
+               ((static_cast<Uint64>(pipeline) & FieldMask) << 36) |
+               ((static_cast<Uint64>(material) & FieldMask) << 24) |
+               ((static_cast<Uint64>(textureSet) & FieldMask) << 12) |
+               (static_cast<Uint64>(depth) & FieldMask);
+    }
+
+    bool SDLDrawSorter::Build(const SDLCommandList& commandList, const std::unordered_set<Tbx::Uid>& orderDependentMaterials)
+    {
+        if (commandList.GetVersion() == _builtVersion)
+        {
+            return false;
+        }
+        _builtVersion = commandList.GetVersion();
+
+        _packets.clear();
+        _uniforms.clear();
+        _pipelineIds.clear();
+        _textureSetIds.clear();
+        _stateChangesSaved = 0;
+
+        const auto& commands = commandList.GetCommands();
+        const auto& materials = commandList.GetMaterials();
+        const auto& meshes = commandList.GetMeshes();
+        const auto& textures = commandList.GetTextures();
+
+        // Only the latest upload per stage and slot is active, so a packet never carries more than one handle per slot
+        Uint32 currentMaterial = SDL_MAX_UINT32;
+        Uint32 activeUniforms[2][SDLUniformArena::MaxSlots];
+        std::fill_n(&activeUniforms[0][0], 2 * SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+        Uint32 segment = 0;
+        Uint32 maxFieldId = 0;
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            const auto& cmd = commands[i];
+            switch (cmd.Type)
+            {
+                case SDLCommandType::Clear:
+                {
+                    segment++;
+                    break;
+                }
+                case SDLCommandType::CompileMaterial:
+                {
+                    currentMaterial = cmd.Handle;
+                    break;
+                }
+                case SDLCommandType::SetMaterial:
+                {
+                    currentMaterial = cmd.Handle;
+                    std::fill_n(&activeUniforms[0][0], 2 * SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+                    break;
+                }
+                case SDLCommandType::UploadUniform:
+                {
+                    const auto& uniform = commandList.GetUniforms()[cmd.Handle];
+                    if (uniform.Slot < SDLUniformArena::MaxSlots)
+                    {
+                        activeUniforms[uniform.IsFragment ? 1 : 0][uniform.Slot] = cmd.Handle;
+                    }
+                    break;
+                }
+                case SDLCommandType::DrawMesh:
+                {
+                    if (currentMaterial == SDL_MAX_UINT32)
+                    {
+                        break;
+                    }
+
+                    const auto& material = materials[currentMaterial];
+                    const auto& mesh = meshes[cmd.Handle];
+                    const bool orderDependent = orderDependentMaterials.contains(material.Id);
+
+                    // Order dependent draws get a segment of their own so nothing is sorted across them
+                    if (orderDependent)
+                    {
+                        segment++;
+                    }
+
+                    SDLPipelineKey pipelineKey = {};
+                    pipelineKey.VertexShader = material.VertexShader;
+                    pipelineKey.FragmentShader = material.FragmentShader;
+                    pipelineKey.Layout = mesh.Layout;
+                    const Uint32 pipeline = Intern(_pipelineIds, SDLPipelineKeyHasher()(pipelineKey));
+
+                    size_t textureSetHash = 0;
+                    for (Uint32 t = material.FirstTexture; t < material.FirstTexture + material.TextureCount; t++)
+                    {
+                        SDLHashCombine(textureSetHash, std::hash<Tbx::Uid>()(textures[t]));
+                    }
+                    const Uint32 textureSet = Intern(_textureSetIds, textureSetHash);
+
+                    SDLDrawPacket packet = {};
+                    // Draw commands carry no view depth yet, so that field stays zero and ties keep submission order.
+                    // Material handles are already interned in first use order, so they are used as the material id directly.
+                    packet.Key = MakeSortKey(segment, pipeline, currentMaterial, textureSet, 0);
+                    maxFieldId = SDL_max(maxFieldId, SDL_max(pipeline, SDL_max(currentMaterial, textureSet)));
+                    packet.DrawCommand = i;
+                    packet.Material = currentMaterial;
+                    packet.FirstUniform = static_cast<Uint32>(_uniforms.size());
+                    for (const auto& stage : activeUniforms)
+                    {
+                        for (const Uint32 uniform : stage)
+                        {
+                            if (uniform != SDL_MAX_UINT32)
+                            {
+                                _uniforms.push_back(uniform);
+                            }
+                        }
+                    }
+                    packet.UniformCount = static_cast<Uint32>(_uniforms.size()) - packet.FirstUniform;
+                    _packets.push_back(packet);
+
+                    if (orderDependent)
+                    {
+                        segment++;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        // The segment field would wrap and move later segments ahead of earlier ones, keep submission order instead
+        if (segment > SegmentMask)
+        {
+            TBX_TRACE_WARN("Frame has {} segments, more than the sort key can order, draws keep submission order", segment + 1);
+            return true;
+        }
+
+        // Ids past a field's range would be masked into ones already in use and interleave unrelated states
+        if (maxFieldId > FieldMask)
+        {
+            TBX_TRACE_WARN("Frame has {} distinct pipelines, materials or texture sets, more than the sort key can tell apart, draws keep submission order", maxFieldId + 1);
+            return true;
+        }
+
+        const Uint32 changesBefore = CountStateChanges();
+        SDLRadixSortPackets(_packets, _scratch);
+        const Uint32 changesAfter = CountStateChanges();
+        _stateChangesSaved = changesBefore > changesAfter ? changesBefore - changesAfter : 0;
+        return true;
+    }
+
+    void SDLDrawSorter::Clear()
+    {
+        _packets.clear();
+        _scratch.clear();
+        _uniforms.clear();
+        _pipelineIds.clear();
+        _textureSetIds.clear();
+        _stateChangesSaved = 0;
+        _builtVersion = 0;
+    }
+
+    Uint32 SDLDrawSorter::Intern(std::unordered_map<Uint64, Uint32>& ids, Uint64 value)
+    {
+        // Ids are handed out in order of first use, so the sort also keeps first use order between states
+        const auto i = ids.find(value);
+        if (i != ids.end())
+        {
+            return i->second;
+        }
+
+        const auto id = static_cast<Uint32>(ids.size());
+        ids.emplace(value, id);
+        return id;
+    }
+
+    Uint32 SDLDrawSorter::CountStateChanges() const
+    {
+        Uint32 changes = 0;
+        for (size_t i = 1; i < _packets.size(); i++)
+        {
+            const Uint64 previous = _packets[i - 1].Key;
+            const Uint64 current = _packets[i].Key;
+            changes += ((previous >> 36) & FieldMask) != ((current >> 36) & FieldMask) ? 1 : 0;
+            changes += ((previous >> 24) & FieldMask) != ((current >> 24) & FieldMask) ? 1 : 0;
+            changes += ((previous >> 12) & FieldMask) != ((current >> 12) & FieldMask) ? 1 : 0;
+        }
+        return changes;
+    }
+
+    void SDLRadixSortPackets(std::vector<SDLDrawPacket>& packets, std::vector<SDLDrawPacket>& scratch)
+    {
+        if (packets.size() < 2)
+        {
+            return;
+        }
+
+        scratch.resize(packets.size());
+        for (Uint32 shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256] = {};
+            for (const auto& packet : packets)
+            {
+                counts[(packet.Key >> shift) & 0xFF]++;
+            }
+
+            // Every key has the same byte here, so this pass wouldn't move anything
+            if (counts[(packets[0].Key >> shift) & 0xFF] == packets.size())
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (auto& count : counts)
+            {
+                const size_t bucketSize = count;
+                count = offset;
+                offset += bucketSize;
+            }
+
+            for (const auto& packet : packets)
+            {
+                scratch[counts[(packet.Key >> shift) & 0xFF]++] = packet;
+            }
+            packets.swap(scratch);
+        }
+    }
+}
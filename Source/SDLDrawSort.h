@@ -0,0 +1,60 @@
+#pragma once
+#include "SDLCommandList.h"
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace SDLRendering
+{
+    // A draw and everything needed to issue it independent of its neighbours
+    struct SDLDrawPacket
+    {
+        Uint64 Key = 0;
+        size_t DrawCommand = 0;
+
+        // Handle of the draw's material in the command list
+        Uint32 Material = 0;
+
+        // Range into SDLDrawSorter::GetUniforms() of the uniform handles active for the draw, at most one per stage and slot
+        Uint32 FirstUniform = 0;
+        Uint32 UniformCount = 0;
+    };
+
+    // Sorts the draws of a frame by a 64 bit state key so pipeline, material and texture bindings change as little as possible.
+    // Key layout from the most significant bit: segment (16), pipeline (12), material (12), texture set (12), depth (12).
+    // Segments are split at clears and around order dependent draws, so those keep their submission order.
+    // A frame with more segments, pipelines, materials or texture sets than their fields hold isn't sorted at all
+    // and keeps submission order, so ids that don't fit never alias.
+    struct SDLDrawSorter
+    {
+    public:
+        // Returns false if the command list didn't change since the last build and the previous order was kept
+        bool Build(const SDLCommandList& commandList, const std::unordered_set<Tbx::Uid>& orderDependentMaterials);
+
+        const std::vector<SDLDrawPacket>& GetPackets() const { return _packets; }
+        const std::vector<Uint32>& GetUniforms() const { return _uniforms; }
+
+        // Pipeline, material and texture set changes avoided by the sort in the last build
+        Uint32 GetStateChangesSaved() const { return _stateChangesSaved; }
+
+        void Clear();
+
+    private:
+        Uint32 Intern(std::unordered_map<Uint64, Uint32>& ids, Uint64 value);
+        Uint32 CountStateChanges() const;
+
+        std::vector<SDLDrawPacket> _packets = {};
+        std::vector<SDLDrawPacket> _scratch = {};
+        std::vector<Uint32> _uniforms = {};
+
+        std::unordered_map<Uint64, Uint32> _pipelineIds = {};
+        std::unordered_map<Uint64, Uint32> _textureSetIds = {};
+
+        Uint32 _stateChangesSaved = 0;
+        Uint64 _builtVersion = 0;
+    };
+
+    // Stable LSD radix sort of the packets by key, passes over bytes that are equal for every key are skipped
+    void SDLRadixSortPackets(std::vector<SDLDrawPacket>& packets, std::vector<SDLDrawPacket>& scratch);
+}
@@ -0,0 +1,77 @@
+#include "SDLFrameGraph.h"
+
+namespace SDLRendering
+{
+    void SDLFrameGraph::Build(const SDLCommandList& commandList, const Tbx::Color& initialClearColor)
+    {
+        _passes.clear();
+
+        // The frame always starts by clearing the swapchain
+        SDLRenderPassNode firstPass = {};
+        firstPass.LoadOp = SDL_GPU_LOADOP_CLEAR;
+        firstPass.ClearColor = { initialClearColor.R, initialClearColor.G, initialClearColor.B, initialClearColor.A };
+        _passes.push_back(firstPass);
+
+        const auto& commands = commandList.GetCommands();
+        const auto& clearColors = commandList.GetClearColors();
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            const auto& cmd = commands[i];
+            switch (cmd.Type)
+            {
+                case SDLCommandType::Clear:
+                {
+                    auto& currentPass = _passes.back();
+                    if (currentPass.DrawCount == 0)
+                    {
+                        // Nothing was drawn yet, so fold the clear into the current pass
+                        currentPass.LoadOp = SDL_GPU_LOADOP_CLEAR;
+                        currentPass.ClearColor = clearColors[cmd.Handle];
+                    }
+                    else
+                    {
+                        currentPass.EndCommand = i;
+
+                        SDLRenderPassNode pass = {};
+                        pass.LoadOp = SDL_GPU_LOADOP_CLEAR;
+                        pass.ClearColor = clearColors[cmd.Handle];
+                        pass.FirstCommand = i;
+                        _passes.push_back(pass);
+                    }
+                    break;
+                }
+                case SDLCommandType::DrawMesh:
+                {
+                    _passes.back().DrawCount++;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        _passes.back().EndCommand = commands.size();
+
+        // Resolve store ops, the last pass is presented so it always has to be stored.
+        // Any earlier pass is followed by a clear of the same target, so its contents are never read again.
+        for (size_t i = 0; i + 1 < _passes.size(); i++)
+        {
+            auto& pass = _passes[i];
+            if (_passes[i + 1].LoadOp == SDL_GPU_LOADOP_CLEAR)
+            {
+                pass.StoreOp = SDL_GPU_STOREOP_DONT_CARE;
+                pass.Culled = true;
+            }
+        }
+        _passes.back().StoreOp = SDL_GPU_STOREOP_STORE;
+    }
+
+    const std::vector<SDLRenderPassNode>& SDLFrameGraph::GetPasses() const
+    {
+        return _passes;
+    }
+
+    void SDLFrameGraph::Clear()
+    {
+        _passes.clear();
+    }
+}
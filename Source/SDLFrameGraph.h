@@ -0,0 +1,38 @@
+#pragma once
+#include "SDLCommandList.h"
+#include <SDL3/SDL.h>
+#include <vector>
+#include <Tbx/Graphics/IRenderer.h>
+
+namespace SDLRendering
+{
+    struct SDLRenderPassNode
+    {
+        SDL_GPULoadOp LoadOp = SDL_GPU_LOADOP_LOAD;
+        SDL_GPUStoreOp StoreOp = SDL_GPU_STOREOP_STORE;
+        SDL_FColor ClearColor = { 0, 0, 0, 0 };
+
+        // Range of commands [FirstCommand, EndCommand) that belong to this pass
+        size_t FirstCommand = 0;
+        size_t EndCommand = 0;
+        Uint32 DrawCount = 0;
+
+        // Nothing the pass writes is ever read, so it doesn't need to be recorded at all
+        bool Culled = false;
+    };
+
+    // Groups the commands of a frame into the minimal set of render passes on the swapchain target.
+    // Consecutive draws share a pass, clears become the load op of the pass that follows them
+    // and passes whose output is overwritten before it is read are culled.
+    struct SDLFrameGraph
+    {
+    public:
+        void Build(const SDLCommandList& commandList, const Tbx::Color& initialClearColor);
+        const std::vector<SDLRenderPassNode>& GetPasses() const;
+
+        void Clear();
+
+    private:
+        std::vector<SDLRenderPassNode> _passes = {};
+    };
+}
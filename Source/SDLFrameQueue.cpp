@@ -0,0 +1,99 @@
+#include "SDLFrameQueue.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    void SDLFrameQueue::Initialize(Uint32 slotCount, SDLFrameBackpressure backpressure, SDLFrameSkip skip)
+    {
+        _slotCount = SDL_clamp(slotCount, 2u, MaxSlots);
+        _backpressure = backpressure;
+        _skip = skip;
+        _written = 0;
+        _released = 0;
+        _closed = false;
+        _droppedCount = 0;
+        _skippedCount = 0;
+    }
+
+    bool SDLFrameQueue::Push(const Tbx::FrameBuffer& buffer, const Tbx::Color& clearColor)
+    {
+        // Only this side moves _written, the consumer only ever frees slots
+        const Uint64 written = _written.load(std::memory_order_relaxed);
+        Uint64 released = _released.load(std::memory_order_acquire);
+        while (written - released == _slotCount)
+        {
+            if (_backpressure == SDLFrameBackpressure::Drop)
+            {
+                _droppedCount++;
+                return false;
+            }
+
+            _released.wait(released, std::memory_order_acquire);
+            released = _released.load(std::memory_order_acquire);
+        }
+
+        SDLFrameSnapshot& slot = _slots[written % _slotCount];
+        slot.Buffer = buffer;
+        slot.ClearColor = clearColor;
+
+        _written.store(written + 1, std::memory_order_release);
+        _signal.fetch_add(1, std::memory_order_release);
+        _signal.notify_one();
+        return true;
+    }
+
+    void SDLFrameQueue::WaitUntilDrained() const
+    {
+        const Uint64 written = _written.load(std::memory_order_relaxed);
+        Uint64 released = _released.load(std::memory_order_acquire);
+        while (released != written && !_closed.load(std::memory_order_acquire))
+        {
+            _released.wait(released, std::memory_order_acquire);
+            released = _released.load(std::memory_order_acquire);
+        }
+    }
+
+    const SDLFrameSnapshot* SDLFrameQueue::BeginRead()
+    {
+        Uint64 released = _released.load(std::memory_order_relaxed);
+        while (true)
+        {
+            // Read the signal before checking, a publish after the check changes it and the wait returns right away
+            const Uint32 signal = _signal.load(std::memory_order_acquire);
+            if (_closed.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+
+            const Uint64 written = _written.load(std::memory_order_acquire);
+            if (written != released)
+            {
+                // Hand the overtaken frames back to the producer without drawing them
+                if (_skip == SDLFrameSkip::Stale && written - released > 1)
+                {
+                    _skippedCount.fetch_add(written - released - 1, std::memory_order_relaxed);
+                    released = written - 1;
+                    _released.store(released, std::memory_order_release);
+                    _released.notify_all();
+                }
+                return &_slots[released % _slotCount];
+            }
+
+            _signal.wait(signal, std::memory_order_acquire);
+        }
+    }
+
+    void SDLFrameQueue::EndRead()
+    {
+        TBX_ASSERT(_released.load(std::memory_order_relaxed) != _written.load(std::memory_order_acquire), "No frame is being read!");
+        _released.fetch_add(1, std::memory_order_release);
+        _released.notify_all();
+    }
+
+    void SDLFrameQueue::Close()
+    {
+        _closed.store(true, std::memory_order_release);
+        _signal.fetch_add(1, std::memory_order_release);
+        _signal.notify_all();
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <Tbx/Graphics/IRenderer.h>
+#include <Tbx/Graphics/Buffers.h>
+
+namespace SDLRendering
+{
+    // What Push does when every slot of the queue is taken
+    enum class SDLFrameBackpressure
+    {
+        // Waits for the render thread to finish a frame, the game never runs more than the slot count ahead
+        Block,
+        // Drops the new frame and returns right away
+        Drop
+    };
+
+    // Which queued frames the render thread draws
+    enum class SDLFrameSkip
+    {
+        // Every frame in the order it was pushed
+        None,
+        // Only the newest, frames that were overtaken while the render thread was busy are skipped
+        Stale
+    };
+
+    // A frame buffer snapshot together with the settings it has to be drawn with
+    struct SDLFrameSnapshot
+    {
+        Tbx::FrameBuffer Buffer = {};
+        Tbx::Color ClearColor = {};
+    };
+
+    // Lock free single producer, single consumer ring of two or three frame snapshots between the game thread and the render thread.
+    // The slot being drawn stays taken until EndRead, so with two slots the game fills one while the other is drawn.
+    // Snapshots are copied into slots that are reused, their containers keep their capacity between frames.
+    struct SDLFrameQueue
+    {
+    public:
+        static constexpr Uint32 MaxSlots = 3;
+
+        // Must not be called while either side is using the queue
+        void Initialize(Uint32 slotCount, SDLFrameBackpressure backpressure, SDLFrameSkip skip);
+
+        // Producer side, false if the frame was dropped
+        bool Push(const Tbx::FrameBuffer& buffer, const Tbx::Color& clearColor);
+
+        // Waits until the consumer released every frame pushed so far
+        void WaitUntilDrained() const;
+
+        // Consumer side, waits for a frame and returns nullptr once the queue is closed
+        const SDLFrameSnapshot* BeginRead();
+        void EndRead();
+
+        // Wakes the consumer, BeginRead returns nullptr from now on
+        void Close();
+
+        Uint32 GetSlotCount() const { return _slotCount; }
+        SDLFrameBackpressure GetBackpressure() const { return _backpressure; }
+        SDLFrameSkip GetFrameSkip() const { return _skip; }
+
+        // Frames Push dropped and frames the consumer skipped as stale, since Initialize
+        Uint64 GetDroppedCount() const { return _droppedCount; }
+        Uint64 GetSkippedCount() const { return _skippedCount.load(std::memory_order_relaxed); }
+
+    private:
+        SDLFrameSnapshot _slots[MaxSlots] = {};
+        Uint32 _slotCount = MaxSlots;
+        SDLFrameBackpressure _backpressure = SDLFrameBackpressure::Block;
+        SDLFrameSkip _skip = SDLFrameSkip::None;
+
+        // Frames published by the producer and released by the consumer, the difference is the number of taken slots
+        std::atomic<Uint64> _written = 0;
+        std::atomic<Uint64> _released = 0;
+
+        // Bumped on every publish and on Close, the consumer sleeps on it
+        std::atomic<Uint32> _signal = 0;
+        std::atomic<bool> _closed = false;
+
+        Uint64 _droppedCount = 0;
+        std::atomic<Uint64> _skippedCount = 0;
+    };
+}
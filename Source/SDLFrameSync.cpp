@@ -0,0 +1,161 @@
+#include "SDLFrameSync.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    SDLFrameFences::~SDLFrameFences()
+    {
+        Clear();
+    }
+
+    void SDLFrameFences::Initialize(SDL_GPUDevice* device)
+    {
+        Clear();
+        _device = device;
+    }
+
+    bool SDLFrameFences::Submit(SDL_GPUCommandBuffer* commandBuffer, Uint64 frame)
+    {
+        SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+        if (fence == nullptr)
+        {
+            TBX_TRACE_ERROR("Failed to submit command buffer: {}", SDL_GetError());
+            return false;
+        }
+
+        if (_fences.empty() || _fences.back().Frame != frame)
+        {
+            _framesInFlight++;
+        }
+
+        FrameFence frameFence = {};
+        frameFence.Frame = frame;
+        frameFence.Fence = fence;
+        _fences.push_back(frameFence);
+        return true;
+    }
+
+    Uint64 SDLFrameFences::Poll()
+    {
+        while (!_fences.empty() && SDL_QueryGPUFence(_device, _fences.front().Fence))
+        {
+            const Uint64 frame = _fences.front().Frame;
+            SDL_ReleaseGPUFence(_device, _fences.front().Fence);
+            _fences.pop_front();
+
+            // The frame is only done once the last of its command buffers is
+            if (_fences.empty() || _fences.front().Frame != frame)
+            {
+                _completedFrame = SDL_max(_completedFrame, frame);
+                _framesInFlight--;
+            }
+        }
+        return _completedFrame;
+    }
+
+    void SDLFrameFences::WaitIdle()
+    {
+        if (_fences.empty())
+        {
+            return;
+        }
+
+        std::vector<SDL_GPUFence*> fences = {};
+        for (const auto& frameFence : _fences)
+        {
+            fences.push_back(frameFence.Fence);
+        }
+        SDL_WaitForGPUFences(_device, true, fences.data(), static_cast<Uint32>(fences.size()));
+        Poll();
+    }
+
+    void SDLFrameFences::Clear()
+    {
+        if (_device != nullptr)
+        {
+            for (const auto& frameFence : _fences)
+            {
+                SDL_ReleaseGPUFence(_device, frameFence.Fence);
+            }
+        }
+        _fences.clear();
+        _framesInFlight = 0;
+    }
+
+    SDLReleaseQueue::~SDLReleaseQueue()
+    {
+        Flush();
+    }
+
+    void SDLReleaseQueue::Initialize(SDL_GPUDevice* device)
+    {
+        Flush();
+        _device = device;
+    }
+
+    void SDLReleaseQueue::BeginFrame(Uint64 frame, Uint64 completedFrame)
+    {
+        _frame = frame;
+
+        // Frames only ever move forward, so the queue is ordered by frame
+        while (!_pending.empty() && _pending.front().Frame <= completedFrame)
+        {
+            Destroy(_pending.front());
+            _pending.pop_front();
+        }
+    }
+
+    void SDLReleaseQueue::Release(SDL_GPUBuffer* buffer)
+    {
+        Release(ResourceType::Buffer, buffer);
+    }
+
+    void SDLReleaseQueue::Release(SDL_GPUTexture* texture)
+    {
+        Release(ResourceType::Texture, texture);
+    }
+
+    void SDLReleaseQueue::Release(SDL_GPUGraphicsPipeline* pipeline)
+    {
+        Release(ResourceType::GraphicsPipeline, pipeline);
+    }
+
+    void SDLReleaseQueue::Flush()
+    {
+        for (const auto& release : _pending)
+        {
+            Destroy(release);
+        }
+        _pending.clear();
+    }
+
+    void SDLReleaseQueue::Release(ResourceType type, void* resource)
+    {
+        if (resource == nullptr)
+        {
+            return;
+        }
+
+        PendingRelease release = {};
+        release.Frame = _frame;
+        release.Type = type;
+        release.Resource = resource;
+        _pending.push_back(release);
+    }
+
+    void SDLReleaseQueue::Destroy(const PendingRelease& release)
+    {
+        switch (release.Type)
+        {
+            case ResourceType::Buffer:
+                SDL_ReleaseGPUBuffer(_device, static_cast<SDL_GPUBuffer*>(release.Resource));
+                break;
+            case ResourceType::Texture:
+                SDL_ReleaseGPUTexture(_device, static_cast<SDL_GPUTexture*>(release.Resource));
+                break;
+            case ResourceType::GraphicsPipeline:
+                SDL_ReleaseGPUGraphicsPipeline(_device, static_cast<SDL_GPUGraphicsPipeline*>(release.Resource));
+                break;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <deque>
+#include <vector>
+
+namespace SDLRendering
+{
+    // Keeps the fence of every submitted frame so the CPU knows which frames the GPU has finished with,
+    // frames are numbered by the caller and are expected to complete in submission order.
+    // A frame may submit several command buffers, it only counts as complete once all of them have.
+    struct SDLFrameFences
+    {
+    public:
+        ~SDLFrameFences();
+
+        void Initialize(SDL_GPUDevice* device);
+
+        // Submits one of the frame's command buffers and keeps its fence, returns false if the submit failed
+        bool Submit(SDL_GPUCommandBuffer* commandBuffer, Uint64 frame);
+
+        // Releases the fences of finished frames and returns the newest frame known to be complete, 0 if none is
+        Uint64 Poll();
+
+        // Blocks until every submitted frame has completed
+        void WaitIdle();
+
+        Uint32 GetFramesInFlight() const { return _framesInFlight; }
+        Uint64 GetCompletedFrame() const { return _completedFrame; }
+
+        void Clear();
+
+    private:
+        struct FrameFence
+        {
+            Uint64 Frame = 0;
+            SDL_GPUFence* Fence = nullptr;
+        };
+
+        std::deque<FrameFence> _fences = {};
+        SDL_GPUDevice* _device = nullptr;
+        Uint64 _completedFrame = 0;
+        Uint32 _framesInFlight = 0;
+    };
+
+    // Parks released GPU objects until the frame that released them has completed, so objects still referenced
+    // by frames in flight are never destroyed under them
+    struct SDLReleaseQueue
+    {
+    public:
+        ~SDLReleaseQueue();
+
+        void Initialize(SDL_GPUDevice* device);
+
+        // Releases everything parked at or before completedFrame, objects released from now on belong to frame
+        void BeginFrame(Uint64 frame, Uint64 completedFrame);
+
+        void Release(SDL_GPUBuffer* buffer);
+        void Release(SDL_GPUTexture* texture);
+        void Release(SDL_GPUGraphicsPipeline* pipeline);
+
+        Uint32 GetPendingCount() const { return static_cast<Uint32>(_pending.size()); }
+
+        // Releases everything right away, only safe once the GPU is idle
+        void Flush();
+
+    private:
+        enum class ResourceType
+        {
+            Buffer,
+            Texture,
+            GraphicsPipeline
+        };
+
+        struct PendingRelease
+        {
+            Uint64 Frame = 0;
+            ResourceType Type = ResourceType::Buffer;
+            void* Resource = nullptr;
+        };
+
+        void Release(ResourceType type, void* resource);
+        void Destroy(const PendingRelease& release);
+
+        std::deque<PendingRelease> _pending = {};
+        SDL_GPUDevice* _device = nullptr;
+        // Frames are counted from 1, objects released before the first frame wait for it
+        Uint64 _frame = 1;
+    };
+}
@@ -0,0 +1,15 @@
+#include "SDLHash.h"
+
+namespace SDLRendering
+{
+    Uint64 SDLHashBytes(const void* data, size_t size, Uint64 hash)
+    {
+        const auto* bytes = static_cast<const Uint8*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+}
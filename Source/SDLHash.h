@@ -0,0 +1,10 @@
+#pragma once
+#include <SDL3/SDL.h>
+
+namespace SDLRendering
+{
+    static constexpr Uint64 SDLHashSeed = 0xcbf29ce484222325ull;
+
+    // 64 bit FNV-1a, chain calls by passing the previous result as the hash
+    Uint64 SDLHashBytes(const void* data, size_t size, Uint64 hash = SDLHashSeed);
+}
@@ -0,0 +1,231 @@
+#include "SDLInstancing.h"
+#include "SDLShader.h"
+#include <algorithm>
+#include <iterator>
+
+namespace SDLRendering
+{
+    static constexpr Sint32 NotBatched = -1;
+    static constexpr Sint32 Folded = -2;
+    static constexpr Sint32 InstanceData = -3;
+
+    SDLInstanceBatcher::~SDLInstanceBatcher()
+    {
+        Clear();
+    }
+
+    bool SDLInstanceBatcher::Build(const SDLCommandList& commandList, const std::unordered_set<Tbx::Uid>& instancedMaterials)
+    {
+        if (commandList.GetVersion() == _builtVersion)
+        {
+            return false;
+        }
+        _builtVersion = commandList.GetVersion();
+
+        const auto& commands = commandList.GetCommands();
+        const auto& uniforms = commandList.GetUniforms();
+        const auto& materials = commandList.GetMaterials();
+
+        _batches.clear();
+        _instanceData.clear();
+        _run.clear();
+        _runData.clear();
+        _runUniforms.clear();
+        _commandBatches.assign(commands.size(), NotBatched);
+
+        // The vertex uniform uploaded to each slot since the last draw, and the commands that uploaded them
+        Uint32 pendingSlots[SDLUniformArena::MaxSlots];
+        std::fill_n(pendingSlots, SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+        std::vector<size_t> pendingCommands = {};
+        bool pendingValid = true;
+
+        Uint32 currentMaterial = SDL_MAX_UINT32;
+        bool currentInstanced = false;
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            const auto& cmd = commands[i];
+            switch (cmd.Type)
+            {
+                case SDLCommandType::Clear:
+                {
+                    FlushRun();
+                    break;
+                }
+                case SDLCommandType::CompileMaterial:
+                case SDLCommandType::SetMaterial:
+                {
+                    // Material handles are interned, so equal handles mean the same material
+                    if (cmd.Handle != currentMaterial)
+                    {
+                        FlushRun();
+                        currentMaterial = cmd.Handle;
+                        currentInstanced = instancedMaterials.contains(materials[cmd.Handle].Id);
+                    }
+                    std::fill_n(pendingSlots, SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+                    pendingCommands.clear();
+                    pendingValid = true;
+                    break;
+                }
+                case SDLCommandType::UploadUniform:
+                {
+                    const auto& uniform = uniforms[cmd.Handle];
+                    if (uniform.IsFragment)
+                    {
+                        // Fragment uniforms are shared by the whole batch, so a change ends the run
+                        FlushRun();
+                    }
+                    else if (uniform.Slot >= SDLUniformArena::MaxSlots)
+                    {
+                        pendingValid = false;
+                    }
+                    else
+                    {
+                        // A later upload to the same slot replaces the earlier one, like it would on the GPU
+                        pendingSlots[uniform.Slot] = cmd.Handle;
+                        pendingCommands.push_back(i);
+                    }
+                    break;
+                }
+                case SDLCommandType::DrawMesh:
+                {
+                    Candidate candidate = {};
+                    candidate.Command = i;
+                    candidate.Mesh = cmd.Handle;
+                    candidate.Material = currentMaterial;
+                    for (Uint32 slot = 0; slot < SDLUniformArena::MaxSlots; slot++)
+                    {
+                        if (pendingSlots[slot] != SDL_MAX_UINT32)
+                        {
+                            candidate.SlotSizes[slot] = uniforms[pendingSlots[slot]].Size;
+                            candidate.DataSize += candidate.SlotSizes[slot];
+                            pendingValid = pendingValid && candidate.SlotSizes[slot] % 16 == 0;
+                        }
+                    }
+
+                    if (!_run.empty())
+                    {
+                        const auto& last = _run.back();
+                        if (last.Mesh != candidate.Mesh || last.Material != candidate.Material ||
+                            !std::equal(std::begin(last.SlotSizes), std::end(last.SlotSizes), std::begin(candidate.SlotSizes)))
+                        {
+                            FlushRun();
+                        }
+                    }
+
+                    // Instance data is fed as float4 attributes to shaders that declare them, anything else can't be instanced
+                    if (!currentInstanced || !pendingValid || candidate.DataSize == 0)
+                    {
+                        FlushRun();
+                    }
+                    else
+                    {
+                        for (Uint32 slot = 0; slot < SDLUniformArena::MaxSlots; slot++)
+                        {
+                            if (pendingSlots[slot] != SDL_MAX_UINT32)
+                            {
+                                const auto& uniform = uniforms[pendingSlots[slot]];
+                                const Uint8* bytes = commandList.GetUniformData(uniform);
+                                _runData.insert(_runData.end(), bytes, bytes + uniform.Size);
+                            }
+                        }
+                        _runUniforms.insert(_runUniforms.end(), pendingCommands.begin(), pendingCommands.end());
+                        _run.push_back(candidate);
+                    }
+
+                    std::fill_n(pendingSlots, SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+                    pendingCommands.clear();
+                    pendingValid = true;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        FlushRun();
+        return true;
+    }
+
+    void SDLInstanceBatcher::Upload(SDLBufferPool& bufferPool, SDLUploadQueue& uploadQueue)
+    {
+        if (_instanceData.empty())
+        {
+            return;
+        }
+
+        const auto dataSize = static_cast<Uint32>(_instanceData.size());
+        // Size classes double, so a growing batch only swaps buffers a handful of times
+        if (_instanceBuffer.Buffer == nullptr || _instanceBuffer.Size < dataSize)
+        {
+            bufferPool.Release(_instanceBuffer);
+            _instanceBuffer = bufferPool.Acquire(SDL_GPU_BUFFERUSAGE_VERTEX, dataSize);
+            _bufferPool = &bufferPool;
+        }
+
+        SDLUploadBuffer(_instanceBuffer.Buffer, dataSize, _instanceData.data(), uploadQueue);
+    }
+
+    const SDLInstanceBatch* SDLInstanceBatcher::GetBatch(size_t commandIndex) const
+    {
+        if (commandIndex >= _commandBatches.size() || _commandBatches[commandIndex] < 0)
+        {
+            return nullptr;
+        }
+        return &_batches[_commandBatches[commandIndex]];
+    }
+
+    bool SDLInstanceBatcher::IsFolded(size_t commandIndex) const
+    {
+        return commandIndex < _commandBatches.size() && _commandBatches[commandIndex] == Folded;
+    }
+
+    bool SDLInstanceBatcher::IsInstanceData(size_t commandIndex) const
+    {
+        return commandIndex < _commandBatches.size() && _commandBatches[commandIndex] == InstanceData;
+    }
+
+    void SDLInstanceBatcher::Clear()
+    {
+        _batches.clear();
+        _commandBatches.clear();
+        _run.clear();
+        _runData.clear();
+        _runUniforms.clear();
+        _instanceData.clear();
+        _builtVersion = 0;
+
+        if (_instanceBuffer.Buffer != nullptr)
+        {
+            _bufferPool->Release(_instanceBuffer);
+            _instanceBuffer = {};
+        }
+    }
+
+    void SDLInstanceBatcher::FlushRun()
+    {
+        // A single draw gains nothing from instancing, it keeps its pushed uniforms
+        if (_run.size() > 1)
+        {
+            SDLInstanceBatch batch = {};
+            batch.FirstCommand = _run.front().Command;
+            batch.InstanceCount = static_cast<Uint32>(_run.size());
+            batch.InstanceStride = _run.front().DataSize;
+            batch.InstanceOffset = static_cast<Uint32>(_instanceData.size());
+            _instanceData.insert(_instanceData.end(), _runData.begin(), _runData.end());
+
+            _commandBatches[batch.FirstCommand] = static_cast<Sint32>(_batches.size());
+            for (size_t i = 1; i < _run.size(); i++)
+            {
+                _commandBatches[_run[i].Command] = Folded;
+            }
+            for (const size_t uniformCommand : _runUniforms)
+            {
+                _commandBatches[uniformCommand] = InstanceData;
+            }
+            _batches.push_back(batch);
+        }
+
+        _run.clear();
+        _runData.clear();
+        _runUniforms.clear();
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "SDLTransfer.h"
+#include "SDLCommandList.h"
+#include "SDLBufferPool.h"
+#include "SDLUniforms.h"
+#include <SDL3/SDL.h>
+#include <unordered_set>
+#include <vector>
+
+namespace SDLRendering
+{
+    struct SDLInstanceBatch
+    {
+        // The draw command that issues the whole batch, the other draws of the run are skipped
+        size_t FirstCommand = 0;
+        Uint32 InstanceCount = 0;
+        Uint32 InstanceStride = 0;
+        Uint32 InstanceOffset = 0;
+    };
+
+    // Finds runs of two or more draws that share a mesh and material and only differ in their vertex uniform data,
+    // and packs that data into a per-instance vertex buffer so each run becomes a single instanced draw.
+    // Only materials whose vertex shader declares the per-instance inputs are folded: the vertex uniforms uploaded
+    // right before each draw become its instance data, in slot order, read as float4 attributes on buffer slot 1
+    // located right after the mesh attributes. Those uniforms aren't pushed for batched draws.
+    // Any other draw, including a run of one, keeps its pushed uniforms and draws as usual.
+    struct SDLInstanceBatcher
+    {
+    public:
+        ~SDLInstanceBatcher();
+
+        // Returns false if the command list didn't change since the last build, the previous batches then still apply.
+        // Call Clear when the set of instanced materials changes.
+        bool Build(const SDLCommandList& commandList, const std::unordered_set<Tbx::Uid>& instancedMaterials);
+        void Upload(SDLBufferPool& bufferPool, SDLUploadQueue& uploadQueue);
+
+        // Returns the batch issued by the given command or nullptr if it isn't the start of one
+        const SDLInstanceBatch* GetBatch(size_t commandIndex) const;
+
+        // Returns true if the given command was folded into a batch issued by an earlier command
+        bool IsFolded(size_t commandIndex) const;
+
+        // Returns true if the given uniform upload is part of a batch's instance data and mustn't be pushed
+        bool IsInstanceData(size_t commandIndex) const;
+
+        SDL_GPUBuffer* GetInstanceBuffer() const { return _instanceBuffer.Buffer; }
+
+        void Clear();
+
+    private:
+        struct Candidate
+        {
+            size_t Command = 0;
+            Uint32 Mesh = 0;
+            Uint32 Material = 0;
+            Uint32 DataSize = 0;
+            Uint32 SlotSizes[SDLUniformArena::MaxSlots] = {};
+        };
+
+        void FlushRun();
+
+        std::vector<SDLInstanceBatch> _batches = {};
+        std::vector<Sint32> _commandBatches = {};
+        std::vector<Candidate> _run = {};
+        std::vector<Uint8> _runData = {};
+        std::vector<size_t> _runUniforms = {};
+        std::vector<Uint8> _instanceData = {};
+
+        SDLPooledBuffer _instanceBuffer = {};
+        SDLBufferPool* _bufferPool = nullptr;
+        Uint64 _builtVersion = 0;
+    };
+}
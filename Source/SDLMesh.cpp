@@ -0,0 +1,185 @@
+#include "SDLMesh.h"
+#include "SDLShader.h"
+#include "SDLHash.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    SDLCachedMesh::SDLCachedMesh(const SDLPooledBuffer& vertexBuffer, const SDLPooledBuffer& indexBuffer, SDLBufferPool* bufferPool)
+    {
+        VertexBuffer = vertexBuffer.Buffer;
+        VertexBufferSize = vertexBuffer.Size;
+        IndexBuffer = indexBuffer.Buffer;
+        IndexBufferSize = indexBuffer.Size;
+        BufferPool = bufferPool;
+    }
+
+    SDLCachedMesh::~SDLCachedMesh()
+    {
+        // Frames in flight may still draw from the buffers, the pool holds them back until those have completed
+        if (VertexBuffer != nullptr)
+        {
+            BufferPool->Release({ VertexBuffer, VertexBufferSize, SDL_GPU_BUFFERUSAGE_VERTEX });
+            VertexBuffer = nullptr;
+        }
+
+        if (IndexBuffer != nullptr)
+        {
+            BufferPool->Release({ IndexBuffer, IndexBufferSize, SDL_GPU_BUFFERUSAGE_INDEX });
+            IndexBuffer = nullptr;
+        }
+    }
+
+    SDLMeshCache::~SDLMeshCache()
+    {
+        Clear();
+    }
+
+    void SDLMeshCache::Add(const Tbx::Mesh& mesh, SDLBufferPool& bufferPool, SDLUploadQueue& uploadQueue)
+    {
+        const auto& vertices = mesh.GetVertexBuffer().GetVertices();
+        const auto verticesSize = static_cast<Uint32>(sizeof(float) * vertices.size());
+
+        const auto& indices = mesh.GetIndices();
+        const auto indicesSize = static_cast<Uint32>(sizeof(Tbx::uint32) * indices.size());
+
+        if (vertices.empty() || indices.empty())
+        {
+            TBX_ASSERT(false, "Cannot cache a mesh without vertices or indices!");
+            return;
+        }
+
+        // Runs for every drawn mesh, so a resident mesh of the same size is only hashed when it is marked dirty
+        // or its turn to be verified comes up within the frame's budget
+        Uint64 contentHash = 0;
+        auto i = _cachedMeshes.find(mesh.GetId());
+        if (i != _cachedMeshes.end())
+        {
+            SDLCachedMesh& cachedMesh = i->second;
+            if (cachedMesh.VertexDataSize == verticesSize && cachedMesh.IndexDataSize == indicesSize)
+            {
+                if (!cachedMesh.Dirty)
+                {
+                    if (cachedMesh.VerifiedCycle == _verificationCycle)
+                    {
+                        return;
+                    }
+
+                    // A frame always verifies at least one mesh, so meshes bigger than the budget still get their turn
+                    const Uint64 size = static_cast<Uint64>(verticesSize) + indicesSize;
+                    if (_verificationBudget != 0 && _verifiedBytes != 0 && _verifiedBytes + size > _verificationBudget)
+                    {
+                        _verificationDeferred = true;
+                        return;
+                    }
+                    _verifiedBytes += size;
+                }
+
+                cachedMesh.Dirty = false;
+                cachedMesh.VerifiedCycle = _verificationCycle;
+                contentHash = SDLHashMesh(mesh);
+                if (contentHash == cachedMesh.ContentHash)
+                {
+                    // Already resident and unchanged, nothing to transfer
+                    return;
+                }
+            }
+
+            // The buffers can only be reused if the data still fits, otherwise swap them for pooled ones of a bigger class
+            if (i->second.VertexBufferSize < verticesSize || i->second.IndexBufferSize < indicesSize)
+            {
+                _cachedMeshes.erase(i);
+                i = _cachedMeshes.end();
+            }
+        }
+
+        if (i == _cachedMeshes.end())
+        {
+            const SDLPooledBuffer vertexBuffer = bufferPool.Acquire(SDL_GPU_BUFFERUSAGE_VERTEX, verticesSize);
+            const SDLPooledBuffer indexBuffer = bufferPool.Acquire(SDL_GPU_BUFFERUSAGE_INDEX, indicesSize);
+            if (vertexBuffer.Buffer == nullptr || indexBuffer.Buffer == nullptr)
+            {
+                // Leave the mesh uncached, its draws are skipped and the next Add tries again
+                bufferPool.Release(vertexBuffer);
+                bufferPool.Release(indexBuffer);
+                return;
+            }
+
+            i = _cachedMeshes.emplace(
+                std::piecewise_construct,
+                std::forward_as_tuple(mesh.GetId()),
+                std::forward_as_tuple(vertexBuffer, indexBuffer, &bufferPool)).first;
+        }
+
+        auto& cachedMesh = i->second;
+        cachedMesh.ContentHash = contentHash != 0 ? contentHash : SDLHashMesh(mesh);
+        cachedMesh.VerifiedCycle = _verificationCycle;
+        cachedMesh.Dirty = false;
+        SDLUploadBuffer(cachedMesh.VertexBuffer, verticesSize, vertices.data(), uploadQueue);
+        SDLUploadBuffer(cachedMesh.IndexBuffer, indicesSize, indices.data(), uploadQueue);
+        cachedMesh.IndexCount = static_cast<Uint32>(indices.size());
+        cachedMesh.VertexDataSize = verticesSize;
+        cachedMesh.IndexDataSize = indicesSize;
+    }
+
+    const SDLCachedMesh* SDLMeshCache::Get(const Tbx::Uid& mesh) const
+    {
+        const auto i = _cachedMeshes.find(mesh);
+        return i != _cachedMeshes.end() ? &i->second : nullptr;
+    }
+
+    bool SDLMeshCache::IsDirty(const Tbx::Mesh& mesh) const
+    {
+        const auto i = _cachedMeshes.find(mesh.GetId());
+        return i == _cachedMeshes.end() ||
+            i->second.VertexDataSize != static_cast<Uint32>(sizeof(float) * mesh.GetVertexBuffer().GetVertices().size()) ||
+            i->second.IndexDataSize != static_cast<Uint32>(sizeof(Tbx::uint32) * mesh.GetIndices().size()) ||
+            i->second.ContentHash != SDLHashMesh(mesh);
+    }
+
+    void SDLMeshCache::MarkDirty(const Tbx::Uid& mesh)
+    {
+        // The flag lives on the entry, so marking a mesh that isn't drawn again costs nothing later on
+        const auto i = _cachedMeshes.find(mesh);
+        if (i != _cachedMeshes.end())
+        {
+            i->second.Dirty = true;
+        }
+    }
+
+    void SDLMeshCache::SetVerificationBudget(Uint64 bytesPerFrame)
+    {
+        _verificationBudget = bytesPerFrame;
+    }
+
+    void SDLMeshCache::BeginFrame()
+    {
+        // Every drawn mesh was verified in the current cycle once a frame gets through all of them
+        if (!_verificationDeferred)
+        {
+            _verificationCycle++;
+        }
+        _verificationDeferred = false;
+        _verifiedBytes = 0;
+    }
+
+    void SDLMeshCache::Remove(const Tbx::Uid& mesh)
+    {
+        _cachedMeshes.erase(mesh);
+    }
+
+    void SDLMeshCache::Clear()
+    {
+        _cachedMeshes.clear();
+    }
+
+    Uint64 SDLHashMesh(const Tbx::Mesh& mesh)
+    {
+        const auto& vertices = mesh.GetVertexBuffer().GetVertices();
+        const auto& indices = mesh.GetIndices();
+
+        Uint64 hash = SDLHashBytes(vertices.data(), sizeof(float) * vertices.size());
+        hash = SDLHashBytes(indices.data(), sizeof(Tbx::uint32) * indices.size(), hash);
+        return hash;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "SDLTransfer.h"
+#include "SDLBufferPool.h"
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <Tbx/Graphics/Buffers.h>
+#include <Tbx/Graphics/Mesh.h>
+
+namespace SDLRendering
+{
+    struct SDLCachedMesh
+    {
+        SDLCachedMesh() = default;
+        SDLCachedMesh(const SDLPooledBuffer& vertexBuffer, const SDLPooledBuffer& indexBuffer, SDLBufferPool* bufferPool);
+        ~SDLCachedMesh();
+
+        SDL_GPUBuffer* VertexBuffer = nullptr;
+        SDL_GPUBuffer* IndexBuffer = nullptr;
+
+        // The buffers came from and go back to this pool
+        SDLBufferPool* BufferPool = nullptr;
+
+        // Capacity of the buffers, the data can grow up to this without new buffers
+        Uint32 VertexBufferSize = 0;
+        Uint32 IndexBufferSize = 0;
+        Uint32 IndexCount = 0;
+
+        // Bytes and hash of the vertex and index data last uploaded
+        Uint32 VertexDataSize = 0;
+        Uint32 IndexDataSize = 0;
+        Uint64 ContentHash = 0;
+
+        // Verification cycle the data was last compared against the GPU copy in, see SDLMeshCache
+        Uint64 VerifiedCycle = 0;
+        bool Dirty = false;
+    };
+
+    struct SDLMeshCache
+    {
+    public:
+        ~SDLMeshCache();
+
+        // Uploads the mesh if it isn't cached yet or if its data changed since the last upload.
+        // A size change is seen right away. Same sized edits are found by hashing: meshes marked dirty are hashed
+        // the next time they are added, the rest are re-hashed in turns within the verification budget.
+        void Add(const Tbx::Mesh& mesh, SDLBufferPool& bufferPool, SDLUploadQueue& uploadQueue);
+        // nullptr if the mesh isn't resident, i.e. it had no data or its buffers couldn't be created
+        const SDLCachedMesh* Get(const Tbx::Uid& mesh) const;
+
+        // Returns true if the mesh would cause an upload when added
+        bool IsDirty(const Tbx::Mesh& mesh) const;
+
+        // Makes the next Add of the mesh compare its data, a no-op for meshes that aren't resident
+        void MarkDirty(const Tbx::Uid& mesh);
+
+        // Bytes of resident mesh data re-hashed per frame to catch edits nobody marked, 0 hashes every drawn mesh every frame.
+        // Every drawn mesh is hashed once per cycle, a new cycle starts after a frame that didn't run out of budget.
+        void SetVerificationBudget(Uint64 bytesPerFrame);
+        Uint64 GetVerificationBudget() const { return _verificationBudget; }
+
+        // Starts a new frame's verification budget
+        void BeginFrame();
+
+        void Remove(const Tbx::Uid& mesh);
+        void Clear();
+
+    private:
+        std::unordered_map<Tbx::Uid, SDLCachedMesh> _cachedMeshes;
+        Uint64 _verificationBudget = 4 * 1024 * 1024;
+        Uint64 _verifiedBytes = 0;
+        Uint64 _verificationCycle = 1;
+        bool _verificationDeferred = false;
+    };
+
+    Uint64 SDLHashMesh(const Tbx::Mesh& mesh);
+}
@@ -0,0 +1,222 @@
+#include "SDLParallelRecorder.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    void SDLRecordState::ResetBindings()
+    {
+        Pipeline = nullptr;
+        Samplers.clear();
+    }
+
+    void SDLRecordDraw(const SDLResolvedDraw& draw, SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass, SDLUniformArena& uniformArena, SDLRecordState& state)
+    {
+        if (draw.Pipeline != state.Pipeline)
+        {
+            SDL_BindGPUGraphicsPipeline(renderPass, draw.Pipeline);
+            state.Pipeline = draw.Pipeline;
+        }
+
+        // bind the vertex buffer, and the instance buffer when drawing a batch
+        SDL_GPUBufferBinding vertexBufferBindings[2];
+        vertexBufferBindings[0] = {};
+        vertexBufferBindings[0].buffer = draw.VertexBuffer;
+        vertexBufferBindings[0].offset = 0;
+        vertexBufferBindings[1] = {};
+        if (draw.InstanceBuffer != nullptr)
+        {
+            vertexBufferBindings[1].buffer = draw.InstanceBuffer;
+            vertexBufferBindings[1].offset = draw.InstanceOffset;
+        }
+        SDL_BindGPUVertexBuffers(renderPass, 0, vertexBufferBindings, draw.InstanceBuffer != nullptr ? 2 : 1);
+
+        // bind the index buffer
+        SDL_GPUBufferBinding indexBufferBindings[1];
+        indexBufferBindings[0] = {};
+        indexBufferBindings[0].buffer = draw.IndexBuffer;
+        indexBufferBindings[0].offset = 0;
+        SDL_BindGPUIndexBuffer(renderPass, indexBufferBindings, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+        // push the uniform slots that changed since the last draw, skipping slots the shaders don't declare
+        uniformArena.Flush(commandBuffer, renderPass, draw.VertexBindings, draw.FragmentBindings);
+
+        // skip the sampler bind when the previous draw left the same textures bound, i.e. textures packed into one array
+        bool samplersChanged = draw.SamplerCount > state.Samplers.size();
+        for (Uint32 s = 0; s < draw.SamplerCount && !samplersChanged; s++)
+        {
+            samplersChanged = draw.Samplers[s].texture != state.Samplers[s].texture ||
+                draw.Samplers[s].sampler != state.Samplers[s].sampler;
+        }
+        if (draw.SamplerCount > 0 && samplersChanged)
+        {
+            SDL_BindGPUFragmentSamplers(renderPass, 0, draw.Samplers, draw.SamplerCount);
+            state.Samplers.assign(draw.Samplers, draw.Samplers + draw.SamplerCount);
+            state.TextureBinds++;
+        }
+
+        // draw the mesh
+        SDL_DrawGPUIndexedPrimitives(renderPass, draw.IndexCount, draw.InstanceCount, 0, 0, 0);
+    }
+
+    SDLParallelRecorder::~SDLParallelRecorder()
+    {
+        Stop();
+    }
+
+    void SDLParallelRecorder::Start(Uint32 workerCount)
+    {
+        Stop();
+
+        _stopping = false;
+        for (Uint32 i = 0; i < SDL_max(workerCount, 1u); i++)
+        {
+            auto worker = std::make_unique<Worker>();
+            worker->Thread = std::thread([this, owner = worker.get()]() { WorkerLoop(*owner); });
+            _workers.push_back(std::move(worker));
+        }
+    }
+
+    void SDLParallelRecorder::Stop()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _workAvailable.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            worker->Thread.join();
+        }
+        _workers.clear();
+    }
+
+    void SDLParallelRecorder::Record(
+        const std::vector<SDLResolvedDraw>& draws,
+        const std::vector<SDLRecordChunk>& chunks,
+        const SDLCommandList& commandList,
+        const SDLUniformArena& stagedUniforms,
+        SDL_GPUTexture* target,
+        SDL_GPUDevice* device)
+    {
+        TBX_ASSERT(IsRunning(), "Parallel recording needs running workers!");
+
+        // Nothing else touches the workers' arenas while they are idle
+        for (auto& worker : _workers)
+        {
+            worker->Uniforms.ShareStorage(stagedUniforms);
+            worker->State.TextureBinds = 0;
+        }
+
+        {
+            std::lock_guard lock(_mutex);
+            _draws = &draws;
+            _chunks = &chunks;
+            _commandList = &commandList;
+            _target = target;
+            _device = device;
+            _nextChunk = 0;
+            _submittedChunks = 0;
+            _busyWorkers = GetWorkerCount();
+            _generation++;
+        }
+        _workAvailable.notify_all();
+
+        // Every chunk is submitted once the last worker runs out of chunks to claim
+        {
+            std::unique_lock lock(_mutex);
+            _chunkSubmitted.wait(lock, [this]() { return _busyWorkers == 0; });
+        }
+
+        _textureBinds = 0;
+        _uniformPushes = 0;
+        for (const auto& worker : _workers)
+        {
+            _textureBinds += worker->State.TextureBinds;
+            _uniformPushes += worker->UniformPushes;
+        }
+    }
+
+    void SDLParallelRecorder::WorkerLoop(Worker& worker)
+    {
+        Uint64 generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(_mutex);
+                _workAvailable.wait(lock, [this, generation]() { return _stopping || _generation != generation; });
+                if (_stopping)
+                {
+                    return;
+                }
+                generation = _generation;
+            }
+
+            // Chunks are claimed in order, so every chunk before a claimed one is already being recorded
+            // and waiting on its predecessors can't stall on work nobody picked up
+            Uint32 pushes = 0;
+            for (size_t chunk = _nextChunk++; chunk < _chunks->size(); chunk = _nextChunk++)
+            {
+                RecordChunk(worker, chunk);
+                pushes += worker.Uniforms.GetPushCount();
+            }
+
+            // The arena's count is per command buffer, leave the frame's total behind for Record to sum up
+            worker.Uniforms.Reset();
+            {
+                std::lock_guard lock(_mutex);
+                worker.UniformPushes = pushes;
+                _busyWorkers--;
+            }
+            _chunkSubmitted.notify_all();
+        }
+    }
+
+    void SDLParallelRecorder::RecordChunk(Worker& worker, size_t chunkIndex)
+    {
+        const SDLRecordChunk& chunk = (*_chunks)[chunkIndex];
+        const auto& draws = *_draws;
+
+        // A new command buffer starts out without any uniform data
+        worker.Uniforms.Reset();
+
+        SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(_device);
+
+        SDL_GPUColorTargetInfo colorTarget = {};
+        colorTarget.texture = _target;
+        colorTarget.clear_color = chunk.ClearColor;
+        colorTarget.load_op = chunk.LoadOp;
+        colorTarget.store_op = SDL_GPU_STOREOP_STORE;
+        SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(commandBuffer, &colorTarget, 1, nullptr);
+        worker.State.ResetBindings();
+
+        for (size_t i = chunk.FirstDraw; i < chunk.EndDraw; i++)
+        {
+            const SDLResolvedDraw& draw = draws[i];
+
+            // Only slots whose bytes differ from what this command buffer last pushed get pushed again
+            for (Uint32 stage = 0; stage < 2; stage++)
+            {
+                for (Uint32 slot = 0; slot < SDLUniformArena::MaxSlots; slot++)
+                {
+                    if (draw.Uniforms[stage][slot] != SDL_MAX_UINT32)
+                    {
+                        worker.Uniforms.Set(draw.Uniforms[stage][slot], *_commandList);
+                    }
+                }
+            }
+
+            SDLRecordDraw(draw, commandBuffer, renderPass, worker.Uniforms, worker.State);
+        }
+
+        SDL_EndGPURenderPass(renderPass);
+
+        // Submit in chunk order, the GPU executes command buffers in the order they were submitted
+        std::unique_lock lock(_mutex);
+        _chunkSubmitted.wait(lock, [this, chunkIndex]() { return _submittedChunks == chunkIndex; });
+        SDL_SubmitGPUCommandBuffer(commandBuffer);
+        _submittedChunks++;
+        lock.unlock();
+        _chunkSubmitted.notify_all();
+    }
+}
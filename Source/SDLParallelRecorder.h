@@ -0,0 +1,125 @@
+#pragma once
+#include "SDLCommandList.h"
+#include "SDLShaderCompiler.h"
+#include "SDLUniforms.h"
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SDLRendering
+{
+    // Everything needed to record a draw, resolved up front so recording doesn't have to touch any of the caches
+    struct SDLResolvedDraw
+    {
+        // SDL GPU guarantees at least this many sampler slots per shader stage
+        static constexpr Uint32 MaxSamplersPerStage = 16;
+
+        SDL_GPUGraphicsPipeline* Pipeline = nullptr;
+        SDL_GPUBuffer* VertexBuffer = nullptr;
+        SDL_GPUBuffer* IndexBuffer = nullptr;
+        SDL_GPUBuffer* InstanceBuffer = nullptr;
+        Uint32 InstanceOffset = 0;
+        Uint32 InstanceCount = 1;
+        Uint32 IndexCount = 0;
+
+        SDLShaderBindings VertexBindings = {};
+        SDLShaderBindings FragmentBindings = {};
+
+        SDL_GPUTextureSamplerBinding Samplers[MaxSamplersPerStage] = {};
+        Uint32 SamplerCount = 0;
+
+        // The uniform handles active for the draw per stage and slot, SDL_MAX_UINT32 where nothing was set.
+        // Only filled in for parallel recording, where a chunk can't inherit them from the draws before it.
+        Uint32 Uniforms[2][SDLUniformArena::MaxSlots] = {};
+    };
+
+    // What a render pass currently has bound, so a draw can skip the binds the previous one already made
+    struct SDLRecordState
+    {
+        void ResetBindings();
+
+        SDL_GPUGraphicsPipeline* Pipeline = nullptr;
+        std::vector<SDL_GPUTextureSamplerBinding> Samplers = {};
+        Uint32 TextureBinds = 0;
+    };
+
+    // Binds the draw's state, pushes the uniform slots the arena has dirty and issues the draw
+    void SDLRecordDraw(const SDLResolvedDraw& draw, SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass, SDLUniformArena& uniformArena, SDLRecordState& state);
+
+    // A run of draws recorded into a render pass and command buffer of its own.
+    // The first chunk of a pass carries the pass's load op, the chunks continuing it load what came before.
+    struct SDLRecordChunk
+    {
+        // Range of draws [FirstDraw, EndDraw)
+        size_t FirstDraw = 0;
+        size_t EndDraw = 0;
+        SDL_GPULoadOp LoadOp = SDL_GPU_LOADOP_LOAD;
+        SDL_FColor ClearColor = { 0, 0, 0, 0 };
+    };
+
+    // A pool of worker threads recording chunks of a frame's draws into command buffers in parallel.
+    // SDL wants command buffers submitted on the thread that acquired them, so every worker acquires, records
+    // and submits its own. Chunks are claimed in order and each waits for the one before it to be submitted,
+    // which keeps the GPU seeing the draws in submission order without a worker ever waiting on unclaimed work.
+    struct SDLParallelRecorder
+    {
+    public:
+        ~SDLParallelRecorder();
+
+        void Start(Uint32 workerCount);
+        void Stop();
+        bool IsRunning() const { return !_workers.empty(); }
+        Uint32 GetWorkerCount() const { return static_cast<Uint32>(_workers.size()); }
+
+        // Records and submits every chunk rendering into the target, returns once all of them are submitted.
+        // The workers' uniform arenas use the storage buffers stagedUniforms uploaded for the frame.
+        void Record(
+            const std::vector<SDLResolvedDraw>& draws,
+            const std::vector<SDLRecordChunk>& chunks,
+            const SDLCommandList& commandList,
+            const SDLUniformArena& stagedUniforms,
+            SDL_GPUTexture* target,
+            SDL_GPUDevice* device);
+
+        // Sampler binds and uniform pushes of the last Record, summed over the workers
+        Uint32 GetTextureBindCount() const { return _textureBinds; }
+        Uint32 GetUniformPushCount() const { return _uniformPushes; }
+
+    private:
+        // Per worker state, kept between frames so the arenas and vectors don't reallocate
+        struct Worker
+        {
+            std::thread Thread;
+            SDLUniformArena Uniforms;
+            SDLRecordState State;
+            Uint32 UniformPushes = 0;
+        };
+
+        void WorkerLoop(Worker& worker);
+        void RecordChunk(Worker& worker, size_t chunkIndex);
+
+        std::vector<std::unique_ptr<Worker>> _workers = {};
+        std::mutex _mutex;
+        std::condition_variable _workAvailable;
+        std::condition_variable _chunkSubmitted;
+
+        // Work of the current Record call
+        const std::vector<SDLResolvedDraw>* _draws = nullptr;
+        const std::vector<SDLRecordChunk>* _chunks = nullptr;
+        const SDLCommandList* _commandList = nullptr;
+        SDL_GPUTexture* _target = nullptr;
+        SDL_GPUDevice* _device = nullptr;
+        std::atomic<size_t> _nextChunk = 0;
+        size_t _submittedChunks = 0;
+        Uint32 _busyWorkers = 0;
+        Uint64 _generation = 0;
+        bool _stopping = false;
+
+        Uint32 _textureBinds = 0;
+        Uint32 _uniformPushes = 0;
+    };
+}
@@ -0,0 +1,173 @@
+#include "SDLPipeline.h"
+#include "SDLShader.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    size_t SDLPipelineKeyHasher::operator()(const SDLPipelineKey& key) const
+    {
+        size_t seed = 0;
+        SDLHashCombine(seed, std::hash<Tbx::Uid>()(key.VertexShader));
+        SDLHashCombine(seed, std::hash<Tbx::Uid>()(key.FragmentShader));
+        SDLHashCombine(seed, static_cast<size_t>(key.ShaderVariant));
+        SDLHashCombine(seed, static_cast<size_t>(key.Layout));
+        SDLHashCombine(seed, static_cast<size_t>(key.InstanceStride));
+        SDLHashCombine(seed, static_cast<size_t>(key.ColorFormat));
+        SDLHashCombine(seed, static_cast<size_t>(key.PrimitiveType));
+        SDLHashCombine(seed, static_cast<size_t>(key.FillMode));
+        SDLHashCombine(seed, static_cast<size_t>(key.CullMode));
+        SDLHashCombine(seed, static_cast<size_t>(key.FrontFace));
+        SDLHashCombine(seed, static_cast<size_t>(key.BlendEnabled));
+        return seed;
+    }
+
+    SDLCachedPipeline::SDLCachedPipeline(SDL_GPUGraphicsPipeline* pipeline, SDLReleaseQueue* releaseQueue, SDL_GPUDevice* device)
+    {
+        Pipeline = pipeline;
+        ReleaseQueue = releaseQueue;
+        Device = device;
+    }
+
+    SDLCachedPipeline::~SDLCachedPipeline()
+    {
+        if (Pipeline != nullptr && ReleaseQueue != nullptr)
+        {
+            ReleaseQueue->Release(Pipeline);
+            Pipeline = nullptr;
+        }
+        else if (Pipeline != nullptr)
+        {
+            SDL_ReleaseGPUGraphicsPipeline(Device, Pipeline);
+            Pipeline = nullptr;
+        }
+    }
+
+    SDLPipelineCache::~SDLPipelineCache()
+    {
+        Clear();
+    }
+
+    SDL_GPUGraphicsPipeline* SDLPipelineCache::GetOrCreate(const SDLPipelineKey& key, const Tbx::BufferLayout& bufferLayout, SDL_GPUShader* vertexShader, SDL_GPUShader* fragmentShader, SDL_GPUDevice* device)
+    {
+        const auto i = _cachedPipelines.find(key);
+        if (i != _cachedPipelines.end())
+        {
+            _hits++;
+            return i->second.Pipeline;
+        }
+
+        _misses++;
+        SDL_GPUGraphicsPipeline* pipeline = SDLCreatePipeline(key, bufferLayout, vertexShader, fragmentShader, device);
+        if (pipeline == nullptr)
+        {
+            TBX_ASSERT(false, "Failed to create graphics pipeline: {}", SDL_GetError());
+            return nullptr;
+        }
+
+        _cachedPipelines.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(pipeline, _releaseQueue, device));
+        return pipeline;
+    }
+
+    void SDLPipelineCache::SetReleaseQueue(SDLReleaseQueue* releaseQueue)
+    {
+        _releaseQueue = releaseQueue;
+    }
+
+    void SDLPipelineCache::Invalidate(const Tbx::Uid& shader)
+    {
+        for (auto i = _cachedPipelines.begin(); i != _cachedPipelines.end();)
+        {
+            if (i->first.VertexShader == shader || i->first.FragmentShader == shader)
+            {
+                i = _cachedPipelines.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    void SDLPipelineCache::Clear()
+    {
+        _cachedPipelines.clear();
+    }
+
+    void SDLHashCombine(size_t& seed, size_t value)
+    {
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    }
+
+    Uint64 SDLHashBufferLayout(const Tbx::BufferLayout& bufferLayout)
+    {
+        size_t seed = 0;
+        SDLHashCombine(seed, static_cast<size_t>(bufferLayout.GetStride()));
+
+        const std::vector<Tbx::BufferElement>& bufferElements = bufferLayout.GetElements();
+        for (const Tbx::BufferElement& bufferElement : bufferElements)
+        {
+            SDLHashCombine(seed, static_cast<size_t>(bufferElement.GetType()));
+            SDLHashCombine(seed, static_cast<size_t>(bufferElement.GetSize()));
+        }
+
+        return static_cast<Uint64>(seed);
+    }
+
+    bool SDLBufferLayoutsEqual(const Tbx::BufferLayout& a, const Tbx::BufferLayout& b)
+    {
+        const std::vector<Tbx::BufferElement>& elementsA = a.GetElements();
+        const std::vector<Tbx::BufferElement>& elementsB = b.GetElements();
+        if (a.GetStride() != b.GetStride() || elementsA.size() != elementsB.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < elementsA.size(); i++)
+        {
+            if (elementsA[i].GetType() != elementsB[i].GetType() || elementsA[i].GetSize() != elementsB[i].GetSize())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    SDL_GPUGraphicsPipeline* SDLCreatePipeline(const SDLPipelineKey& key, const Tbx::BufferLayout& bufferLayout, SDL_GPUShader* vertexShader, SDL_GPUShader* fragmentShader, SDL_GPUDevice* device)
+    {
+        std::vector<SDL_GPUVertexAttribute> vertexAttributes = SDLCreateVertexAttributes(bufferLayout, key.InstanceStride);
+        std::vector<SDL_GPUVertexBufferDescription> vertexBufferDesctiptions = SDLCreateVertexBufferDescriptions(bufferLayout, key.InstanceStride);
+
+        SDL_GPUColorTargetDescription colorTargetDescriptions[1];
+        colorTargetDescriptions[0] = {};
+        colorTargetDescriptions[0].format = key.ColorFormat;
+        if (key.BlendEnabled)
+        {
+            colorTargetDescriptions[0].blend_state.enable_blend = true;
+            colorTargetDescriptions[0].blend_state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+            colorTargetDescriptions[0].blend_state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+            colorTargetDescriptions[0].blend_state.color_blend_op = SDL_GPU_BLENDOP_ADD;
+            colorTargetDescriptions[0].blend_state.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+            colorTargetDescriptions[0].blend_state.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+            colorTargetDescriptions[0].blend_state.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+        }
+
+        SDL_GPUGraphicsPipelineCreateInfo graphicsPipelineInfo = {};
+        graphicsPipelineInfo.vertex_shader = vertexShader;
+        graphicsPipelineInfo.fragment_shader = fragmentShader;
+        graphicsPipelineInfo.primitive_type = key.PrimitiveType;
+        graphicsPipelineInfo.vertex_input_state.num_vertex_attributes = (Uint32)vertexAttributes.size();
+        graphicsPipelineInfo.vertex_input_state.vertex_attributes = &vertexAttributes[0];
+        graphicsPipelineInfo.vertex_input_state.num_vertex_buffers = (Uint32)vertexBufferDesctiptions.size();
+        graphicsPipelineInfo.vertex_input_state.vertex_buffer_descriptions = &vertexBufferDesctiptions[0];
+        graphicsPipelineInfo.rasterizer_state.fill_mode = key.FillMode;
+        graphicsPipelineInfo.rasterizer_state.cull_mode = key.CullMode;
+        graphicsPipelineInfo.rasterizer_state.front_face = key.FrontFace;
+        graphicsPipelineInfo.target_info.num_color_targets = 1;
+        graphicsPipelineInfo.target_info.color_target_descriptions = colorTargetDescriptions;
+
+        return SDL_CreateGPUGraphicsPipeline(device, &graphicsPipelineInfo);
+    }
+}
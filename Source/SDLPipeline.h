@@ -0,0 +1,77 @@
+#pragma once
+#include "SDLFrameSync.h"
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <Tbx/Graphics/Buffers.h>
+#include <Tbx/Graphics/Material.h>
+
+namespace SDLRendering
+{
+    struct SDLPipelineKey
+    {
+        Tbx::Uid VertexShader;
+        Tbx::Uid FragmentShader;
+        Uint32 ShaderVariant = 0;
+        // Index of the vertex layout in SDLCommandList::GetLayouts()
+        Uint32 Layout = 0;
+        Uint32 InstanceStride = 0;
+        SDL_GPUTextureFormat ColorFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+        SDL_GPUPrimitiveType PrimitiveType = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+        SDL_GPUFillMode FillMode = SDL_GPU_FILLMODE_FILL;
+        SDL_GPUCullMode CullMode = SDL_GPU_CULLMODE_NONE;
+        SDL_GPUFrontFace FrontFace = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE;
+        bool BlendEnabled = false;
+
+        bool operator==(const SDLPipelineKey& other) const = default;
+    };
+
+    struct SDLPipelineKeyHasher
+    {
+        size_t operator()(const SDLPipelineKey& key) const;
+    };
+
+    struct SDLCachedPipeline
+    {
+        SDLCachedPipeline() = default;
+        SDLCachedPipeline(SDL_GPUGraphicsPipeline* pipeline, SDLReleaseQueue* releaseQueue, SDL_GPUDevice* device);
+        ~SDLCachedPipeline();
+
+        SDL_GPUGraphicsPipeline* Pipeline = nullptr;
+        // Released through the queue when set, so frames in flight can finish drawing with the pipeline
+        SDLReleaseQueue* ReleaseQueue = nullptr;
+        SDL_GPUDevice* Device = nullptr;
+    };
+
+    struct SDLPipelineCache
+    {
+    public:
+        ~SDLPipelineCache();
+
+        SDL_GPUGraphicsPipeline* GetOrCreate(const SDLPipelineKey& key, const Tbx::BufferLayout& bufferLayout, SDL_GPUShader* vertexShader, SDL_GPUShader* fragmentShader, SDL_GPUDevice* device);
+
+        // Pipelines leaving the cache are handed to the queue instead of being released right away
+        void SetReleaseQueue(SDLReleaseQueue* releaseQueue);
+
+        // Releases every pipeline that was built from the given shader
+        void Invalidate(const Tbx::Uid& shader);
+        void Clear();
+
+        Uint64 GetHits() const { return _hits; }
+        Uint64 GetMisses() const { return _misses; }
+
+    private:
+        std::unordered_map<SDLPipelineKey, SDLCachedPipeline, SDLPipelineKeyHasher> _cachedPipelines;
+        SDLReleaseQueue* _releaseQueue = nullptr;
+        Uint64 _hits = 0;
+        Uint64 _misses = 0;
+    };
+
+    void SDLHashCombine(size_t& seed, size_t value);
+
+    Uint64 SDLHashBufferLayout(const Tbx::BufferLayout& bufferLayout);
+
+    // True when both layouts describe the same vertex attributes
+    bool SDLBufferLayoutsEqual(const Tbx::BufferLayout& a, const Tbx::BufferLayout& b);
+
+    SDL_GPUGraphicsPipeline* SDLCreatePipeline(const SDLPipelineKey& key, const Tbx::BufferLayout& bufferLayout, SDL_GPUShader* vertexShader, SDL_GPUShader* fragmentShader, SDL_GPUDevice* device);
+}
@@ -0,0 +1,183 @@
+#include "SDLPixelConversion.h"
+
+namespace SDLRendering
+{
+    using ConvertRGBToRGBAFunc = void(*)(const Uint8*, Uint8*, size_t);
+
+    static void ConvertRGBToRGBAScalar(const Uint8* source, Uint8* destination, size_t pixelCount)
+    {
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            destination[0] = source[0];
+            destination[1] = source[1];
+            destination[2] = source[2];
+            destination[3] = 0xFF;
+            source += 3;
+            destination += 4;
+        }
+    }
+
+#ifdef SDL_SSE4_1_INTRINSICS
+    static void SDL_TARGETING("sse4.1") ConvertRGBToRGBASSE41(const Uint8* source, Uint8* destination, size_t pixelCount)
+    {
+        // Spreads 4 packed pixels out to 4 bytes each, the alpha lanes are zeroed and then or'ed in
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+        // Each load reads 16 bytes for 12 bytes of pixels, so stop while the last load is still in bounds
+        size_t i = 0;
+        for (; i + 18 <= pixelCount; i += 16)
+        {
+            const Uint8* in = source + i * 3;
+            Uint8* out = destination + i * 4;
+            const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12));
+            const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 24));
+            const __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 36));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_or_si128(_mm_shuffle_epi8(p0, shuffle), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_or_si128(_mm_shuffle_epi8(p1, shuffle), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 32), _mm_or_si128(_mm_shuffle_epi8(p2, shuffle), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 48), _mm_or_si128(_mm_shuffle_epi8(p3, shuffle), alpha));
+        }
+
+        ConvertRGBToRGBAScalar(source + i * 3, destination + i * 4, pixelCount - i);
+    }
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+    static void SDL_TARGETING("avx2") ConvertRGBToRGBAAVX2(const Uint8* source, Uint8* destination, size_t pixelCount)
+    {
+        // Same as the SSE kernel, with 4 pixels in each 128 bit lane since the shuffle can't cross lanes
+        const __m256i shuffle = _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        size_t i = 0;
+        for (; i + 34 <= pixelCount; i += 32)
+        {
+            const Uint8* in = source + i * 3;
+            Uint8* out = destination + i * 4;
+            for (size_t group = 0; group < 4; group++)
+            {
+                const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + group * 24));
+                const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + group * 24 + 12));
+                const __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + group * 32), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+            }
+        }
+
+        ConvertRGBToRGBAScalar(source + i * 3, destination + i * 4, pixelCount - i);
+    }
+#endif
+
+#ifdef SDL_NEON_INTRINSICS
+    static void ConvertRGBToRGBANEON(const Uint8* source, Uint8* destination, size_t pixelCount)
+    {
+        // The structured loads and stores do the (de)interleaving for us
+        const uint8x16_t alpha = vdupq_n_u8(0xFF);
+
+        size_t i = 0;
+        for (; i + 16 <= pixelCount; i += 16)
+        {
+            const uint8x16x3_t rgb = vld3q_u8(source + i * 3);
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = rgb.val[2];
+            rgba.val[3] = alpha;
+            vst4q_u8(destination + i * 4, rgba);
+        }
+
+        ConvertRGBToRGBAScalar(source + i * 3, destination + i * 4, pixelCount - i);
+    }
+#endif
+
+    static ConvertRGBToRGBAFunc SelectConvertRGBToRGBA()
+    {
+#ifdef SDL_AVX2_INTRINSICS
+        if (SDL_HasAVX2())
+        {
+            return ConvertRGBToRGBAAVX2;
+        }
+#endif
+#ifdef SDL_SSE4_1_INTRINSICS
+        if (SDL_HasSSE41())
+        {
+            return ConvertRGBToRGBASSE41;
+        }
+#endif
+#ifdef SDL_NEON_INTRINSICS
+        if (SDL_HasNEON())
+        {
+            return ConvertRGBToRGBANEON;
+        }
+#endif
+        return ConvertRGBToRGBAScalar;
+    }
+
+    void SDLConvertRGBToRGBA(const Uint8* source, Uint8* destination, size_t pixelCount)
+    {
+        static const ConvertRGBToRGBAFunc convert = SelectConvertRGBToRGBA();
+        convert(source, destination, pixelCount);
+    }
+
+    Uint32 SDLGetMipLevelCount(Uint32 width, Uint32 height)
+    {
+        Uint32 levels = 1;
+        for (Uint32 size = SDL_max(width, height); size > 1; size >>= 1)
+        {
+            levels++;
+        }
+        return levels;
+    }
+
+    void SDLGenerateMipChain(std::vector<Uint8>& pixels, Uint32 width, Uint32 height)
+    {
+        const Uint32 levelCount = SDLGetMipLevelCount(width, height);
+
+        // Reserve up front, the source level is read from the same vector while the next one is appended
+        size_t chainSize = 0;
+        for (Uint32 level = 0; level < levelCount; level++)
+        {
+            chainSize += static_cast<size_t>(SDL_max(width >> level, 1u)) * SDL_max(height >> level, 1u) * 4;
+        }
+        pixels.reserve(chainSize);
+
+        size_t sourceOffset = 0;
+        Uint32 sourceWidth = width;
+        Uint32 sourceHeight = height;
+        for (Uint32 level = 1; level < levelCount; level++)
+        {
+            const Uint32 levelWidth = SDL_max(sourceWidth >> 1, 1u);
+            const Uint32 levelHeight = SDL_max(sourceHeight >> 1, 1u);
+            const size_t levelOffset = pixels.size();
+            pixels.resize(levelOffset + static_cast<size_t>(levelWidth) * levelHeight * 4);
+
+            const Uint8* source = pixels.data() + sourceOffset;
+            Uint8* destination = pixels.data() + levelOffset;
+            for (Uint32 y = 0; y < levelHeight; y++)
+            {
+                const Uint32 y0 = SDL_min(y * 2, sourceHeight - 1);
+                const Uint32 y1 = SDL_min(y * 2 + 1, sourceHeight - 1);
+                for (Uint32 x = 0; x < levelWidth; x++)
+                {
+                    const Uint32 x0 = SDL_min(x * 2, sourceWidth - 1);
+                    const Uint32 x1 = SDL_min(x * 2 + 1, sourceWidth - 1);
+                    const Uint8* p00 = source + (static_cast<size_t>(y0) * sourceWidth + x0) * 4;
+                    const Uint8* p01 = source + (static_cast<size_t>(y0) * sourceWidth + x1) * 4;
+                    const Uint8* p10 = source + (static_cast<size_t>(y1) * sourceWidth + x0) * 4;
+                    const Uint8* p11 = source + (static_cast<size_t>(y1) * sourceWidth + x1) * 4;
+                    for (Uint32 channel = 0; channel < 4; channel++)
+                    {
+                        *destination++ = static_cast<Uint8>((p00[channel] + p01[channel] + p10[channel] + p11[channel] + 2) / 4);
+                    }
+                }
+            }
+
+            sourceOffset = levelOffset;
+            sourceWidth = levelWidth;
+            sourceHeight = levelHeight;
+        }
+    }
+}
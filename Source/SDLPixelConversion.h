@@ -0,0 +1,28 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+
+namespace SDLRendering
+{
+    enum class SDLMipmapMode
+    {
+        // Only the base level
+        None,
+        // The chain is generated on the GPU after the base level is uploaded
+        Gpu,
+        // The chain is box filtered on the CPU and uploaded level by level
+        Cpu
+    };
+
+    // Expands tightly packed RGB24 pixels into RGBA32 with an opaque alpha.
+    // Picks the widest kernel the CPU supports (AVX2, SSE4.1 or NEON) and falls back to a scalar loop,
+    // the destination may be mapped transfer memory so it is only ever written, never read.
+    void SDLConvertRGBToRGBA(const Uint8* source, Uint8* destination, size_t pixelCount);
+
+    // Number of levels in a full mip chain down to 1x1
+    Uint32 SDLGetMipLevelCount(Uint32 width, Uint32 height);
+
+    // Appends every mip level below the RGBA32 base level held in pixels, each a 2x2 box filter of the one above.
+    // Odd sizes clamp at the edge, so the chain is valid for non power of two textures too.
+    void SDLGenerateMipChain(std::vector<Uint8>& pixels, Uint32 width, Uint32 height);
+}
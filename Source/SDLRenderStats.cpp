@@ -0,0 +1,51 @@
+#include "SDLRenderStats.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    void SDLRenderStats::SetHistorySize(Uint32 frameCount)
+    {
+        _historySize = SDL_max(frameCount, 1u);
+        _frames.clear();
+        _next = 0;
+        _count = 0;
+    }
+
+    void SDLRenderStats::BeginFrame()
+    {
+        _current = {};
+    }
+
+    void SDLRenderStats::EndFrame(Uint64 frame, const SDLStatTotals& totals)
+    {
+        _current.Frame = frame;
+        _current.PipelineCreations = totals.PipelineCreations - _lastTotals.PipelineCreations;
+        _current.ShaderCreations = totals.ShaderCreations - _lastTotals.ShaderCreations;
+        _current.TextureUploads = totals.TextureUploads - _lastTotals.TextureUploads;
+        _current.BytesTransferred = totals.BytesTransferred - _lastTotals.BytesTransferred;
+        _lastTotals = totals;
+
+        // The ring is only allocated once something is recorded
+        if (_frames.size() != _historySize)
+        {
+            _frames.resize(_historySize);
+        }
+        _frames[_next] = _current;
+        _next = (_next + 1) % _historySize;
+        _count = SDL_min(_count + 1, _historySize);
+    }
+
+    const SDLFrameStats& SDLRenderStats::GetFrame(Uint32 age) const
+    {
+        TBX_ASSERT(age < _count, "Only {} frames have been recorded!", _count);
+        return _frames[(_next + _historySize - 1 - age) % _historySize];
+    }
+
+    void SDLRenderStats::Clear()
+    {
+        _frames.clear();
+        _current = {};
+        _next = 0;
+        _count = 0;
+    }
+}
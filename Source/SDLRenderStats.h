@@ -0,0 +1,140 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+
+// Renderer stats are recorded in debug builds, define TBX_RENDERER_STATS as 0 or 1 to override.
+// When 0 the recording macros compile to nothing, the stats surface stays but never fills.
+#ifndef TBX_RENDERER_STATS
+    #ifdef TBX_DEBUG
+        #define TBX_RENDERER_STATS 1
+    #else
+        #define TBX_RENDERER_STATS 0
+    #endif
+#endif
+
+#define TBX_RENDERER_STAT_CONCAT_INNER(a, b) a##b
+#define TBX_RENDERER_STAT_CONCAT(a, b) TBX_RENDERER_STAT_CONCAT_INNER(a, b)
+
+#if TBX_RENDERER_STATS
+    // Adds the time until the end of the enclosing scope to the timer of the frame being recorded
+    #define TBX_RENDERER_STAT_SCOPE(stats, timer) ::SDLRendering::SDLStatScope TBX_RENDERER_STAT_CONCAT(statScope, __LINE__)((stats).GetCurrent(), (timer))
+    #define TBX_RENDERER_STAT_ADD(stats, counter, value) ((stats).GetCurrent().counter += (value))
+    #define TBX_RENDERER_STATS_ONLY(code) code
+#else
+    #define TBX_RENDERER_STAT_SCOPE(stats, timer) ((void)0)
+    #define TBX_RENDERER_STAT_ADD(stats, counter, value) ((void)0)
+    #define TBX_RENDERER_STATS_ONLY(code)
+#endif
+
+namespace SDLRendering
+{
+    // CPU time is measured where the work happens, so a command type's timer covers both staging and recording it.
+    // Clears become load ops of the render passes and cost nothing on their own.
+    enum class SDLStatTimer
+    {
+        // All of Draw
+        Frame,
+        // Fence polling, swapchain acquisition and cache maintenance
+        BeginDraw,
+        // Lowering the frame buffer into the command list
+        Translate,
+        // Instance, uniform storage and upload queue recording
+        Upload,
+        CompileMaterial,
+        SetMaterial,
+        UploadUniform,
+        DrawMesh,
+        // Waiting on the workers when recording in parallel
+        Record,
+        // Recording the copy of the parallel recording target onto the swapchain
+        Blit,
+        Submit,
+        Count
+    };
+
+    struct SDLFrameStats
+    {
+        // The renderer's frame index, a skipped frame carries the index of the last frame drawn before it
+        Uint64 Frame = 0;
+
+        // The frame didn't get a swapchain texture and wasn't drawn, only its BeginDraw and Frame times are set
+        bool Skipped = false;
+
+        Uint32 Draws = 0;
+        Uint32 RenderPasses = 0;
+        Uint32 CopyPasses = 0;
+        Uint32 UniformPushes = 0;
+        Uint64 PipelineCreations = 0;
+        Uint64 ShaderCreations = 0;
+        // Texture copies, one per mip level and array layer uploaded
+        Uint64 TextureUploads = 0;
+        Uint64 BytesTransferred = 0;
+
+        // Workers the frame was recorded with, 0 when it was recorded on the render thread
+        Uint32 RecordWorkers = 0;
+        // Bytes the GPU reads and writes to copy the parallel recording target onto the swapchain, the extra
+        // bandwidth parallel recording costs. SDL GPU has no timestamp queries, so its GPU time can't be reported.
+        Uint64 BlitBytes = 0;
+
+        // Nanoseconds spent per SDLStatTimer
+        Uint64 Times[static_cast<size_t>(SDLStatTimer::Count)] = {};
+
+        Uint64 GetTime(SDLStatTimer timer) const { return Times[static_cast<size_t>(timer)]; }
+    };
+
+    // Running totals of the counters the caches keep, turned into per frame counts by SDLRenderStats::EndFrame
+    struct SDLStatTotals
+    {
+        Uint64 PipelineCreations = 0;
+        Uint64 ShaderCreations = 0;
+        Uint64 TextureUploads = 0;
+        Uint64 BytesTransferred = 0;
+    };
+
+    // Keeps the stats of the last frames in a ring, the frame being recorded is kept apart until it ends
+    struct SDLRenderStats
+    {
+    public:
+        // Frames kept, older ones are overwritten. Resizing drops the recorded history.
+        void SetHistorySize(Uint32 frameCount);
+        Uint32 GetHistorySize() const { return _historySize; }
+
+        void BeginFrame();
+        void EndFrame(Uint64 frame, const SDLStatTotals& totals);
+        SDLFrameStats& GetCurrent() { return _current; }
+
+        // Recorded frames, age 0 is the most recent one
+        Uint32 GetFrameCount() const { return _count; }
+        const SDLFrameStats& GetFrame(Uint32 age) const;
+
+        void Clear();
+
+    private:
+        std::vector<SDLFrameStats> _frames = {};
+        SDLFrameStats _current = {};
+        SDLStatTotals _lastTotals = {};
+        Uint32 _historySize = 120;
+        Uint32 _next = 0;
+        Uint32 _count = 0;
+    };
+
+    // Measures the lifetime of the scope into one of the frame's timers
+    struct SDLStatScope
+    {
+    public:
+        SDLStatScope(SDLFrameStats& stats, SDLStatTimer timer)
+            : _stats(stats), _timer(timer), _start(SDL_GetTicksNS())
+        {
+        }
+
+        ~SDLStatScope()
+        {
+            _stats.Times[static_cast<size_t>(_timer)] += SDL_GetTicksNS() - _start;
+        }
+
+    private:
+        SDLFrameStats& _stats;
+        SDLStatTimer _timer;
+        Uint64 _start = 0;
+    };
+}
@@ -3,9 +3,13 @@
 #include <Tbx/Graphics/Material.h>
 #include <Tbx/Graphics/Mesh.h>
 #include <Tbx/App/App.h>
+#include <algorithm>
 
 namespace SDLRendering
 {
+    // SDL GPU allows at most this many frames in flight
+    static constexpr Uint32 MaxFramesInFlight = 3;
+
     //////////////// LOGGING ////////////////
 
     static void SDLCALL TbxLogHandler(void* userdata,
@@ -86,6 +90,16 @@ namespace SDLRendering
         });
         TBX_ASSERT(_device, "Failed to create SDL_Renderer: {}", SDL_GetError());
         SDL_ClaimWindowForGPUDevice(_device.get(), window);
+        SDL_SetGPUAllowedFramesInFlight(_device.get(), _framesInFlight);
+        ApplySwapchainParameters();
+        _frameFences.Initialize(_device.get());
+        _releaseQueue.Initialize(_device.get());
+        _bufferPool.Initialize(_device.get());
+        _pipelineCache.SetReleaseQueue(&_releaseQueue);
+
+        // One persistently owned upload buffer per frame in flight, grown on demand
+        _uploadQueue.Initialize(_device.get(), MaxFramesInFlight, 16 * 1024 * 1024);
+        _textureCache.Initialize(_device.get(), _uploadQueue);
 
         // Init size and resolution
         int w, h;
@@ -93,15 +107,55 @@ namespace SDLRendering
         _resolution = { w, h };
         _viewport = { { 0, 0 }, { w, h } };
 
+        // Keep compiled shaders and compressed textures around between runs
+        if (char* prefPath = SDL_GetPrefPath("Toybox", "SDL3 Rendering"))
+        {
+            _shaderCache.SetDiskCacheDirectory(std::string(prefPath) + "ShaderCache");
+            _textureCache.SetDiskCacheDirectory(std::string(prefPath) + "TextureCache");
+            SDL_free(prefPath);
+        }
+
+        // Pipelines reference their shaders, so drop them whenever a shader leaves the cache
+        _shaderCache.SetEvictionCallback([this](const Tbx::Uid& shader)
+        {
+            _pipelineCache.Invalidate(shader);
+        });
+
         InstallSdlLogger();
     }
 
     void SDLRenderer::Shutdown()
     {
+        StopRenderThread();
         Flush();
+        _frameFences.WaitIdle();
+        _frameFences.Clear();
+
+        _parallelRecorder.Stop();
+        _resolvedDraws.clear();
+        _recordChunks.clear();
+        if (_parallelTarget != nullptr)
+        {
+            SDL_ReleaseGPUTexture(_device.get(), _parallelTarget);
+            _parallelTarget = nullptr;
+        }
 
+        _shaderCache.SetAsyncCompilation(0);
+        _textureCache.SetStreaming(0, 0);
+        _pipelineCache.Clear();
+        _instanceBatcher.Clear();
+        _drawSorter.Clear();
+        _uniformArena.Clear();
+        _commandList.Clear();
+        _compiledMaterials.clear();
+        _meshCache.Clear();
         _shaderCache.Clear();
         _textureCache.Clear();
+        _uploadQueue.Clear();
+
+        // The GPU is idle by now, everything parked can go right away
+        _releaseQueue.Flush();
+        _bufferPool.Clear();
 
         _device.reset();
     }
@@ -146,22 +200,351 @@ namespace SDLRendering
 
     void SDLRenderer::SetVSyncEnabled(bool enabled)
     {
-        _vsyncEnabled = enabled;
+        SetPresentMode(enabled ? SDL_GPU_PRESENTMODE_VSYNC : SDL_GPU_PRESENTMODE_MAILBOX);
     }
 
     bool SDLRenderer::GetVSyncEnabled()
     {
-        return _vsyncEnabled;
+        return _requestedPresentMode == SDL_GPU_PRESENTMODE_VSYNC;
+    }
+
+    void SDLRenderer::SetPresentMode(SDL_GPUPresentMode mode)
+    {
+        _requestedPresentMode = mode;
+        ApplySwapchainParameters();
+    }
+
+    void SDLRenderer::SetFramesInFlight(Uint32 count)
+    {
+        _framesInFlight = SDL_clamp(count, 1u, MaxFramesInFlight);
+        if (_device && !SDL_SetGPUAllowedFramesInFlight(_device.get(), _framesInFlight))
+        {
+            TBX_TRACE_WARN("Failed to set frames in flight: {}", SDL_GetError());
+        }
+    }
+
+    void SDLRenderer::SetSwapchainAcquireMode(SDLSwapchainAcquireMode mode)
+    {
+        _swapchainAcquireMode = mode;
+    }
+
+    void SDLRenderer::ApplySwapchainParameters()
+    {
+        // Applied once the device exists if set before Initialize
+        if (!_device || !_surface)
+        {
+            return;
+        }
+
+        // VSYNC is the only mode every window supports. The fallback is only applied, the request is left as is.
+        auto* window = (SDL_Window*)_surface->GetNativeWindow();
+        SDL_GPUPresentMode mode = _requestedPresentMode;
+        if (mode == SDL_GPU_PRESENTMODE_MAILBOX && !SDL_WindowSupportsGPUPresentMode(_device.get(), window, mode))
+        {
+            mode = SDL_GPU_PRESENTMODE_IMMEDIATE;
+        }
+        if (mode == SDL_GPU_PRESENTMODE_IMMEDIATE && !SDL_WindowSupportsGPUPresentMode(_device.get(), window, mode))
+        {
+            mode = SDL_GPU_PRESENTMODE_VSYNC;
+        }
+        if (mode != _requestedPresentMode)
+        {
+            TBX_TRACE_WARN("The window doesn't support the requested present mode {}, presenting with {} instead", static_cast<int>(_requestedPresentMode), static_cast<int>(mode));
+        }
+
+        // On failure the swapchain keeps presenting with the mode applied before
+        if (!SDL_SetGPUSwapchainParameters(_device.get(), window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode))
+        {
+            TBX_TRACE_WARN("Failed to set the present mode: {}", SDL_GetError());
+            return;
+        }
+        _appliedPresentMode = mode;
+    }
+
+    void SDLRenderer::SetInstancingEnabled(bool enabled)
+    {
+        _instancingEnabled = enabled;
+    }
+
+    bool SDLRenderer::GetInstancingEnabled() const
+    {
+        return _instancingEnabled;
+    }
+
+    void SDLRenderer::SetMaterialInstanced(const Tbx::Uid& material, bool instanced)
+    {
+        if (instanced)
+        {
+            _instancedMaterials.insert(material);
+        }
+        else
+        {
+            _instancedMaterials.erase(material);
+        }
+
+        // Batches are only rebuilt when the command list changes otherwise
+        _instanceBatcher.Clear();
+    }
+
+    void SDLRenderer::SetSortingEnabled(bool enabled)
+    {
+        _sortingEnabled = enabled;
+    }
+
+    bool SDLRenderer::GetSortingEnabled() const
+    {
+        return _sortingEnabled;
+    }
+
+    void SDLRenderer::SetMaterialTransparent(const Tbx::Uid& material, bool transparent)
+    {
+        if (transparent)
+        {
+            _transparentMaterials.insert(material);
+        }
+        else
+        {
+            _transparentMaterials.erase(material);
+        }
+
+        // The sort segments depend on which materials are transparent
+        _drawSorter.Clear();
+    }
+
+    void SDLRenderer::SetMaterialBlended(const Tbx::Uid& material, bool blended)
+    {
+        // Blending is part of the pipeline key, so the next draw picks up the matching pipeline
+        if (blended)
+        {
+            _blendedMaterials.insert(material);
+        }
+        else
+        {
+            _blendedMaterials.erase(material);
+        }
+    }
+
+    void SDLRenderer::SetTextureStreaming(Uint32 workerCount, Uint32 bytesPerFrame)
+    {
+        _textureCache.SetStreaming(workerCount, bytesPerFrame);
+    }
+
+    SDLTextureResidency SDLRenderer::GetTextureResidency(const Tbx::Uid& texture) const
+    {
+        return _textureCache.GetResidency(texture);
+    }
+
+    Uint32 SDLRenderer::GetStreamingTextureCount() const
+    {
+        return _textureCache.GetStreamingCount();
+    }
+
+    void SDLRenderer::SetDefaultMipmapMode(SDLMipmapMode mode)
+    {
+        _textureCache.SetDefaultMipmapMode(mode);
+    }
+
+    void SDLRenderer::SetTextureMipmapMode(const Tbx::Uid& texture, SDLMipmapMode mode)
+    {
+        _textureCache.SetMipmapMode(texture, mode);
+    }
+
+    void SDLRenderer::SetDefaultTextureCompression(SDLTextureCompression compression)
+    {
+        _textureCache.SetDefaultCompression(compression);
+    }
+
+    void SDLRenderer::SetTextureCompression(const Tbx::Uid& texture, SDLTextureCompression compression)
+    {
+        _textureCache.SetCompression(texture, compression);
+    }
+
+    void SDLRenderer::SetTextureArrayPacking(const Tbx::Uid& texture, bool packed)
+    {
+        _textureCache.SetArrayPacking(texture, packed);
+    }
+
+    void SDLRenderer::SetTextureArrayPackingLimits(Uint32 maxSize, Uint32 layerCount)
+    {
+        _textureCache.SetArrayPackingLimits(maxSize, layerCount);
+    }
+
+    Uint32 SDLRenderer::GetTextureLayer(const Tbx::Uid& texture)
+    {
+        return _textureCache.GetResidency(texture) == SDLTextureResidency::Resident ? _textureCache.Get(texture).Layer : 0;
+    }
+
+    void SDLRenderer::SetTextureMemoryBudget(Uint64 bytes)
+    {
+        _textureCache.SetMemoryBudget(bytes);
+    }
+
+    void SDLRenderer::SetShaderMemoryBudget(Uint64 bytes)
+    {
+        _shaderCache.SetMemoryBudget(bytes);
+    }
+
+    void SDLRenderer::RemoveTexture(const Tbx::Uid& texture)
+    {
+        _textureCache.Remove(texture);
+    }
+
+    void SDLRenderer::RemoveShader(const Tbx::Uid& shader)
+    {
+        _shaderCache.Remove(shader);
+    }
+
+    void SDLRenderer::SetParallelRecording(Uint32 workerCount, Uint32 drawsPerChunk)
+    {
+        _drawsPerChunk = SDL_max(drawsPerChunk, 1u);
+        if (workerCount == 0)
+        {
+            _parallelRecorder.Stop();
+        }
+        else if (workerCount != _parallelRecorder.GetWorkerCount())
+        {
+            _parallelRecorder.Start(workerCount);
+        }
+    }
+
+    void SDLRenderer::MarkMeshDirty(const Tbx::Uid& mesh)
+    {
+        _meshCache.MarkDirty(mesh);
+    }
+
+    void SDLRenderer::SetMeshVerificationBudget(Uint64 bytesPerFrame)
+    {
+        _meshCache.SetVerificationBudget(bytesPerFrame);
+    }
+
+    void SDLRenderer::SetUniformStorageThreshold(Uint32 size)
+    {
+        _uniformArena.SetStorageThreshold(size);
+    }
+
+    void SDLRenderer::SetMaterialDefines(const Tbx::Uid& material, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+        {
+            _materialVariants.erase(material);
+        }
+        else
+        {
+            _materialVariants[material] = _shaderVariants.Intern(defines);
+        }
+
+        // Pipelines and sort keys are picked per material, drop the ones built for the old variant
+        _drawSorter.Clear();
+        _compiledMaterials.erase(material);
+    }
+
+    const SDLShaderVariant& SDLRenderer::GetMaterialVariant(const Tbx::Uid& material) const
+    {
+        static const SDLShaderVariant defaultVariant = {};
+
+        const auto i = _materialVariants.find(material);
+        return i != _materialVariants.end() ? i->second : defaultVariant;
+    }
+
+    void SDLRenderer::SetAsyncShaderCompilation(Uint32 workerCount)
+    {
+        _shaderCache.SetAsyncCompilation(workerCount);
+    }
+
+    Uint32 SDLRenderer::GetPendingShaderCompilations() const
+    {
+        return _shaderCache.GetPendingCount();
+    }
+
+    void SDLRenderer::SetFallbackMaterial(const Tbx::Material& material)
+    {
+        // The previous fallback can be evicted like anything else again
+        if (_hasFallbackMaterial)
+        {
+            _shaderCache.SetPinned(_fallbackVertexShader, false);
+            _shaderCache.SetPinned(_fallbackFragmentShader, false);
+            for (const auto& texture : _fallbackTextures)
+            {
+                _textureCache.SetPinned(texture, false);
+            }
+        }
+
+        // The fallback has to be usable right away, so it never goes through the workers, and it is never evicted
+        const SDLShaderVariant& variant = GetMaterialVariant(material.GetId());
+        _shaderCache.Add(material.GetVertexShader(), variant, _device.get(), false);
+        _shaderCache.Add(material.GetFragmentShader(), variant, _device.get(), false);
+        _shaderCache.SetPinned(material.GetVertexShader(), true);
+        _shaderCache.SetPinned(material.GetFragmentShader(), true);
+
+        _fallbackTextures.clear();
+        for (const auto& texture : material.GetTextures())
+        {
+            _textureCache.Add(texture, _device.get(), _uploadQueue);
+            _textureCache.SetPinned(texture.GetId(), true);
+            _fallbackTextures.push_back(texture.GetId());
+        }
+
+        _fallbackMaterial = material.GetId();
+        _fallbackVertexShader = material.GetVertexShader();
+        _fallbackFragmentShader = material.GetFragmentShader();
+        _hasFallbackMaterial = true;
+    }
+
+    Uint32 SDLRenderer::GetStateChangesSaved() const
+    {
+        return _sortingEnabled ? _drawSorter.GetStateChangesSaved() : 0;
+    }
+
+    void SDLRenderer::SetRenderThread(bool enabled, Uint32 slotCount, SDLFrameBackpressure backpressure, SDLFrameSkip skip)
+    {
+        StopRenderThread();
+        if (!enabled)
+        {
+            return;
+        }
+
+        _frameQueue.Initialize(slotCount, backpressure, skip);
+        _renderThread = std::thread([this]() { RenderThreadLoop(); });
+    }
+
+    void SDLRenderer::RenderThreadLoop()
+    {
+        while (const SDLFrameSnapshot* frame = _frameQueue.BeginRead())
+        {
+            DrawFrame(frame->Buffer, frame->ClearColor);
+            _frameQueue.EndRead();
+        }
+    }
+
+    void SDLRenderer::StopRenderThread()
+    {
+        if (!_renderThread.joinable())
+        {
+            return;
+        }
+
+        // Draw what was already handed over before the thread leaves
+        _frameQueue.WaitUntilDrained();
+        _frameQueue.Close();
+        _renderThread.join();
     }
 
     void SDLRenderer::Flush()
     {
+        // Every frame is recorded and submitted by the render thread, once it is idle there is nothing left on this one
+        if (_renderThread.joinable())
+        {
+            _frameQueue.WaitUntilDrained();
+        }
+
         EndRenderPass();
         SubmitCommandBuffer();
     }
 
     void SDLRenderer::Clear(const Tbx::Color& color)
     {
+        EndRenderPass();
+
         _currColorTarget = {};
         _currColorTarget.clear_color = { color.R, color.G, color.B, color.A };
         _currColorTarget.load_op = SDL_GPU_LOADOP_CLEAR;
@@ -173,69 +556,511 @@ namespace SDLRendering
 
     void SDLRenderer::Draw(const Tbx::FrameBuffer& buffer)
     {
-        SDL_Window* window = (SDL_Window*)_surface.get()->GetNativeWindow();
-        if (!TryBeginDraw(window))
+        // The settings are read here so the render thread never touches the app
+        const Tbx::Color clearColor = Tbx::App::GetInstance()->GetGraphicsSettings().ClearColor;
+        if (_renderThread.joinable())
         {
+            _frameQueue.Push(buffer, clearColor);
             return;
         }
 
-        for (const auto& cmd : buffer.GetCommands())
+        DrawFrame(buffer, clearColor);
+    }
+
+    void SDLRenderer::DrawFrame(const Tbx::FrameBuffer& buffer, const Tbx::Color& clearColor)
+    {
+#if TBX_RENDERER_STATS
+        _stats.BeginFrame();
+        bool drawn = false;
         {
-            switch (cmd.GetType())
+            SDLStatScope frameScope(_stats.GetCurrent(), SDLStatTimer::Frame);
+            drawn = RecordFrame(buffer, clearColor);
+        }
+        RecordFrameStats(!drawn);
+#else
+        RecordFrame(buffer, clearColor);
+#endif
+    }
+
+    bool SDLRenderer::RecordFrame(const Tbx::FrameBuffer& buffer, const Tbx::Color& clearColor)
+    {
+        SDL_Window* window = (SDL_Window*)_surface.get()->GetNativeWindow();
+        {
+            TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::BeginDraw);
+            if (!TryBeginDraw(window))
             {
-                case Tbx::DrawCommandType::Clear:
+                return false;
+            }
+        }
+
+        // Lower the frame buffer into a flat command list, this is skipped when it matches last frame's
+        {
+            TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::Translate);
+            _commandList.Translate(buffer);
+        }
+
+        // Make every shader, texture and mesh the frame uses resident, even when the command list was reused
+        StageUploads(buffer);
+
+        const bool parallel = _parallelRecorder.IsRunning();
+        {
+            TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::Upload);
+
+            // Pack the per instance data of repeated draws
+            if (_instancingEnabled && !_sortingEnabled && _instanceBatcher.Build(_commandList, _instancedMaterials))
+            {
+                _instanceBatcher.Upload(_bufferPool, _uploadQueue);
+            }
+
+            // Upload the uniform blocks that are too big to push
+            _uniformArena.Stage(_commandList, _bufferPool, _uploadQueue);
+
+            // Record every upload of the frame up front so no copy pass has to break a render pass.
+            // Recorded chunks are submitted ahead of the frame's command buffer, so their uploads need one submitted before them.
+            SDL_GPUCommandBuffer* uploadCommandBuffer = parallel ? SDL_AcquireGPUCommandBuffer(_device.get()) : _currCommandBuffer;
+            if (_uploadQueue.Submit(uploadCommandBuffer))
+            {
+                _frameCopyPasses++;
+            }
+            if (parallel)
+            {
+                // Fenced as part of the frame, so what it copies from isn't reused before the copies are done
+                _frameFences.Submit(uploadCommandBuffer, _frameIndex);
+            }
+        }
+
+        // Group the commands into render passes, clears become load ops of the passes instead of passes of their own
+        _frameGraph.Build(_commandList, clearColor);
+
+        if (parallel)
+        {
+            DrawPassesParallel(window);
+        }
+        else if (_sortingEnabled)
+        {
+            DrawPassesSorted(window);
+        }
+        else
+        {
+            DrawPasses(window);
+        }
+
+        {
+            TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::Submit);
+            EndDraw();
+        }
+        return true;
+    }
+
+    void SDLRenderer::RecordFrameStats(bool skipped)
+    {
+        SDLFrameStats& stats = _stats.GetCurrent();
+        stats.Skipped = skipped;
+        if (!skipped)
+        {
+            stats.RenderPasses = _frameRenderPasses;
+            stats.CopyPasses = _frameCopyPasses;
+            stats.UniformPushes = GetUniformPushCount();
+        }
+
+        SDLStatTotals totals = {};
+        totals.PipelineCreations = _pipelineCache.GetMisses();
+        totals.ShaderCreations = _shaderCache.GetCreatedCount();
+        totals.TextureUploads = _uploadQueue.GetSubmittedTextureUploads();
+        totals.BytesTransferred = _uploadQueue.GetSubmittedBytes();
+        _stats.EndFrame(_frameIndex, totals);
+    }
+
+    void SDLRenderer::DrawPasses(SDL_Window* window)
+    {
+        const bool instancing = _instancingEnabled;
+        const auto& commands = _commandList.GetCommands();
+
+        // Handles are only valid for the current command list
+        _currentMaterial = SDL_MAX_UINT32;
+
+        for (const auto& pass : _frameGraph.GetPasses())
+        {
+            if (!pass.Culled)
+            {
+                BeginRenderPass(pass);
+            }
+
+            for (size_t i = pass.FirstCommand; i < pass.EndCommand; i++)
+            {
+                const auto& cmd = commands[i];
+                switch (cmd.Type)
                 {
-                    const auto& color = std::any_cast<const Tbx::Color&>(cmd.GetPayload());
-                    Clear(color);
-                    break;
+                    case SDLCommandType::CompileMaterial:
+                    {
+                        // Already compiled by StageUploads, it only selects the material here
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::CompileMaterial);
+                        _currentMaterial = cmd.Handle;
+                        break;
+                    }
+                    case SDLCommandType::SetMaterial:
+                    {
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::SetMaterial);
+                        SetMaterial(cmd.Handle);
+                        break;
+                    }
+                    case SDLCommandType::UploadUniform:
+                    {
+                        // Uniforms that became instance data are read from the instance buffer instead
+                        if (instancing && _instanceBatcher.IsInstanceData(i))
+                        {
+                            break;
+                        }
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::UploadUniform);
+                        UploadShaderData(cmd.Handle);
+                        break;
+                    }
+                    case SDLCommandType::DrawMesh:
+                    {
+                        // Draws of a culled pass would be overwritten before they are ever seen,
+                        // and draws folded into an instanced batch are issued by the batch's first draw
+                        if (pass.Culled || (instancing && _instanceBatcher.IsFolded(i)))
+                        {
+                            break;
+                        }
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::DrawMesh);
+                        DrawMesh(cmd.Handle, window, instancing ? _instanceBatcher.GetBatch(i) : nullptr);
+                        break;
+                    }
+                    default:
+                        break;
                 }
-                case Tbx::DrawCommandType::CompileMaterial:
+            }
+
+            EndRenderPass();
+        }
+    }
+
+    void SDLRenderer::DrawPassesSorted(SDL_Window* window)
+    {
+        _drawSorter.Build(_commandList, _transparentMaterials);
+
+        const auto& commands = _commandList.GetCommands();
+        const auto& packets = _drawSorter.GetPackets();
+        const auto& packetUniforms = _drawSorter.GetUniforms();
+
+        // Packets never cross a clear, so each pass consumes a contiguous range of the sorted packets
+        size_t nextPacket = 0;
+        for (const auto& pass : _frameGraph.GetPasses())
+        {
+            if (!pass.Culled)
+            {
+                BeginRenderPass(pass);
+            }
+
+            for (; nextPacket < packets.size() && packets[nextPacket].DrawCommand < pass.EndCommand; nextPacket++)
+            {
+                const auto& packet = packets[nextPacket];
+                if (pass.Culled)
                 {
-                    CompileMaterial(cmd);
-                    break;
+                    continue;
                 }
-                case Tbx::DrawCommandType::SetMaterial:
+
+                // Replay the uniforms that were active for this draw in submission order, only changed slots get pushed
+                _currentMaterial = packet.Material;
+                {
+                    TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::UploadUniform);
+                    for (Uint32 u = 0; u < packet.UniformCount; u++)
+                    {
+                        _uniformArena.Set(packetUniforms[packet.FirstUniform + u], _commandList);
+                    }
+                }
+
+                TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::DrawMesh);
+                DrawMesh(commands[packet.DrawCommand].Handle, window);
+            }
+
+            EndRenderPass();
+        }
+    }
+
+    void SDLRenderer::DrawPassesParallel(SDL_Window* window)
+    {
+        const bool instancing = _instancingEnabled && !_sortingEnabled;
+        const auto& commands = _commandList.GetCommands();
+        const auto& uniforms = _commandList.GetUniforms();
+
+        // Handles are only valid for the current command list
+        _currentMaterial = SDL_MAX_UINT32;
+        _resolvedDraws.clear();
+        _recordChunks.clear();
+
+        // A chunk can't inherit uniforms from the chunk before it, so every draw carries the uniforms active for it
+        Uint32 activeUniforms[2][SDLUniformArena::MaxSlots];
+        std::fill_n(&activeUniforms[0][0], 2 * SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+
+        if (_sortingEnabled)
+        {
+            _drawSorter.Build(_commandList, _transparentMaterials);
+        }
+        const auto& packets = _drawSorter.GetPackets();
+        const auto& packetUniforms = _drawSorter.GetUniforms();
+        size_t nextPacket = 0;
+
+        // Resolve every draw on this thread, the caches aren't safe to touch from the workers
+        for (const auto& pass : _frameGraph.GetPasses())
+        {
+            const size_t firstDraw = _resolvedDraws.size();
+            for (size_t i = pass.FirstCommand; i < pass.EndCommand && !_sortingEnabled; i++)
+            {
+                const auto& cmd = commands[i];
+                switch (cmd.Type)
+                {
+                    case SDLCommandType::CompileMaterial:
+                    {
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::CompileMaterial);
+                        _currentMaterial = cmd.Handle;
+                        break;
+                    }
+                    case SDLCommandType::SetMaterial:
+                    {
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::SetMaterial);
+                        _currentMaterial = cmd.Handle;
+                        break;
+                    }
+                    case SDLCommandType::UploadUniform:
+                    {
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::UploadUniform);
+                        const auto& uniform = uniforms[cmd.Handle];
+                        if (uniform.Slot < SDLUniformArena::MaxSlots && !(instancing && _instanceBatcher.IsInstanceData(i)))
+                        {
+                            activeUniforms[uniform.IsFragment ? 1 : 0][uniform.Slot] = cmd.Handle;
+                        }
+                        break;
+                    }
+                    case SDLCommandType::DrawMesh:
+                    {
+                        if (pass.Culled || (instancing && _instanceBatcher.IsFolded(i)))
+                        {
+                            break;
+                        }
+
+                        TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::DrawMesh);
+                        SDLResolvedDraw& draw = _resolvedDraws.emplace_back();
+                        if (!ResolveDraw(cmd.Handle, window, instancing ? _instanceBatcher.GetBatch(i) : nullptr, draw))
+                        {
+                            _resolvedDraws.pop_back();
+                            break;
+                        }
+                        SDL_memcpy(draw.Uniforms, activeUniforms, sizeof(activeUniforms));
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+
+            // Packets never cross a clear and carry the uniforms that were active for them in submission order
+            for (; _sortingEnabled && nextPacket < packets.size() && packets[nextPacket].DrawCommand < pass.EndCommand; nextPacket++)
+            {
+                const auto& packet = packets[nextPacket];
+                if (pass.Culled)
+                {
+                    continue;
+                }
+
+                TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::DrawMesh);
+                _currentMaterial = packet.Material;
+                SDLResolvedDraw& draw = _resolvedDraws.emplace_back();
+                if (!ResolveDraw(commands[packet.DrawCommand].Handle, window, nullptr, draw))
+                {
+                    _resolvedDraws.pop_back();
+                    continue;
+                }
+
+                std::fill_n(&draw.Uniforms[0][0], 2 * SDLUniformArena::MaxSlots, SDL_MAX_UINT32);
+                for (Uint32 u = 0; u < packet.UniformCount; u++)
+                {
+                    const Uint32 uniform = packetUniforms[packet.FirstUniform + u];
+                    if (uniforms[uniform].Slot < SDLUniformArena::MaxSlots)
+                    {
+                        draw.Uniforms[uniforms[uniform].IsFragment ? 1 : 0][uniforms[uniform].Slot] = uniform;
+                    }
+                }
+            }
+
+            if (pass.Culled)
+            {
+                continue;
+            }
+
+            // Split the pass into chunks, the first one clears and the others continue on what it drew.
+            // A clear without draws still needs a chunk of its own.
+            const size_t endDraw = _resolvedDraws.size();
+            size_t chunkStart = firstDraw;
+            do
+            {
+                if (chunkStart == endDraw && pass.LoadOp != SDL_GPU_LOADOP_CLEAR)
                 {
-                    SetMaterial(cmd);
                     break;
                 }
-                case Tbx::DrawCommandType::UploadMaterialData:
+
+                SDLRecordChunk& chunk = _recordChunks.emplace_back();
+                chunk.FirstDraw = chunkStart;
+                chunk.EndDraw = SDL_min(chunkStart + _drawsPerChunk, endDraw);
+                chunk.LoadOp = chunkStart == firstDraw ? pass.LoadOp : SDL_GPU_LOADOP_LOAD;
+                chunk.ClearColor = pass.ClearColor;
+                chunkStart = chunk.EndDraw;
+            } while (chunkStart < endDraw);
+        }
+
+        if (_recordChunks.empty())
+        {
+            return;
+        }
+
+        SDL_GPUTexture* target = GetParallelTarget(window);
+        if (target == nullptr)
+        {
+            return;
+        }
+
+        {
+            TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::Record);
+            _parallelRecorder.Record(_resolvedDraws, _recordChunks, _commandList, _uniformArena, target, _device.get());
+        }
+        TBX_RENDERER_STAT_ADD(_stats, Draws, static_cast<Uint32>(_resolvedDraws.size()));
+        TBX_RENDERER_STAT_ADD(_stats, RecordWorkers, _parallelRecorder.GetWorkerCount());
+        _frameRenderPasses += static_cast<Uint32>(_recordChunks.size());
+        _recordState.TextureBinds += _parallelRecorder.GetTextureBindCount();
+        _frameParallelUniformPushes = _parallelRecorder.GetUniformPushCount();
+
+        // The swapchain texture belongs to the frame's command buffer, so the workers draw offscreen and it gets copied over
+        SDL_GPUBlitInfo blit = {};
+        blit.source.texture = target;
+        blit.source.w = _swapchainWidth;
+        blit.source.h = _swapchainHeight;
+        blit.destination.texture = _currSwapchainTexture;
+        blit.destination.w = _swapchainWidth;
+        blit.destination.h = _swapchainHeight;
+        blit.load_op = SDL_GPU_LOADOP_DONT_CARE;
+        blit.filter = SDL_GPU_FILTER_NEAREST;
+        {
+            TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::Blit);
+            SDL_BlitGPUTexture(_currCommandBuffer, &blit);
+        }
+        TBX_RENDERER_STAT_ADD(_stats, BlitBytes, 2ull * _swapchainWidth * _swapchainHeight * SDL_GPUTextureFormatTexelBlockSize(_parallelTargetFormat));
+    }
+
+    SDL_GPUTexture* SDLRenderer::GetParallelTarget(SDL_Window* window)
+    {
+        const SDL_GPUTextureFormat format = SDL_GetGPUSwapchainTextureFormat(_device.get(), window);
+        if (_parallelTarget != nullptr &&
+            _parallelTargetFormat == format &&
+            _parallelTargetWidth == _swapchainWidth &&
+            _parallelTargetHeight == _swapchainHeight)
+        {
+            return _parallelTarget;
+        }
+
+        // Frames still in flight may be drawing into the old one
+        if (_parallelTarget != nullptr)
+        {
+            _releaseQueue.Release(_parallelTarget);
+        }
+
+        // Sampled so it can be blitted from
+        SDL_GPUTextureCreateInfo info = {};
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.format = format;
+        info.width = _swapchainWidth;
+        info.height = _swapchainHeight;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        info.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        _parallelTarget = SDL_CreateGPUTexture(_device.get(), &info);
+        if (_parallelTarget == nullptr)
+        {
+            TBX_TRACE_ERROR("Failed to create the parallel recording target: {}", SDL_GetError());
+        }
+
+        _parallelTargetFormat = format;
+        _parallelTargetWidth = _swapchainWidth;
+        _parallelTargetHeight = _swapchainHeight;
+        return _parallelTarget;
+    }
+
+    void SDLRenderer::StageUploads(const Tbx::FrameBuffer& buffer)
+    {
+        for (const auto& cmd : buffer.GetCommands())
+        {
+            switch (cmd.GetType())
+            {
+                case Tbx::DrawCommandType::CompileMaterial:
                 {
-                    UploadShaderData(cmd);
+                    TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::CompileMaterial);
+                    CompileMaterial(cmd);
                     break;
                 }
                 case Tbx::DrawCommandType::DrawMesh:
                 {
-                    DrawMesh(cmd, window);
+                    TBX_RENDERER_STAT_SCOPE(_stats, SDLStatTimer::DrawMesh);
+                    const auto& mesh = std::any_cast<const Tbx::Mesh&>(cmd.GetPayload());
+                    _meshCache.Add(mesh, _bufferPool, _uploadQueue);
                     break;
                 }
                 default:
                     break;
             }
         }
-
-        EndDraw();
     }
 
     bool SDLRenderer::TryBeginDraw(SDL_Window* window)
     {
-        // Acquire the command buffer
-        _currCommandBuffer = SDL_AcquireGPUCommandBuffer(_device.get());
+        // Find out which frames the GPU has finished
+        const Uint64 completedFrame = _frameFences.Poll();
 
-        // Get the swapchain texture
+        // Without waiting there is no point in asking for a swapchain texture while every frame is still in flight
+        const bool blocking = _swapchainAcquireMode == SDLSwapchainAcquireMode::Blocking;
+        if (!blocking && _frameFences.GetFramesInFlight() >= _framesInFlight)
+        {
+            _skippedFrames++;
+            return false;
+        }
+
+        // Acquire the command buffer and the swapchain texture before anything is staged, so a skipped frame leaves no work behind
+        _currCommandBuffer = SDL_AcquireGPUCommandBuffer(_device.get());
         Uint32 width, height;
-        SDL_WaitAndAcquireGPUSwapchainTexture(_currCommandBuffer, window, &_currSwapchainTexture, &width, &height);
+        const bool acquired = blocking
+            ? SDL_WaitAndAcquireGPUSwapchainTexture(_currCommandBuffer, window, &_currSwapchainTexture, &width, &height)
+            : SDL_AcquireGPUSwapchainTexture(_currCommandBuffer, window, &_currSwapchainTexture, &width, &height);
 
         // End the frame early if a swapchain texture is not available
-        if (_currSwapchainTexture == nullptr)
+        if (!acquired || _currSwapchainTexture == nullptr)
         {
             // you must always submit the command buffer
             SDL_SubmitGPUCommandBuffer(_currCommandBuffer);
+            _currCommandBuffer = nullptr;
+            _skippedFrames++;
             return false;
         }
-        
-        // Clear screen
-        Clear(Tbx::App::GetInstance()->GetGraphicsSettings().ClearColor);
+
+        // Start writing uploads into the next frame's transfer buffer, the command buffer starts out without any uniform data
+        _frameIndex++;
+        _uploadQueue.BeginFrame();
+        _uniformArena.Reset();
+        _meshCache.BeginFrame();
+        _swapchainWidth = width;
+        _swapchainHeight = height;
+        _frameCopyPasses = 0;
+        _frameRenderPasses = 0;
+        _frameParallelUniformPushes = 0;
+        _recordState.TextureBinds = 0;
+
+        // Release what the GPU is done with and evict down to the memory budgets before this frame adds anything
+        _releaseQueue.BeginFrame(_frameIndex, completedFrame);
+        _bufferPool.BeginFrame(_frameIndex, completedFrame);
+        _shaderCache.BeginFrame(_frameIndex, completedFrame);
+        _textureCache.BeginFrame(_frameIndex, completedFrame);
+
+        // Pick up shaders that finished compiling in the background, and upload this frame's share of streamed textures
+        _shaderCache.ProcessCompleted(_device.get());
+        _textureCache.ProcessStreaming(_device.get(), _uploadQueue);
 
         return true;
     }
@@ -249,6 +1074,21 @@ namespace SDLRendering
     void SDLRenderer::BeginRenderPass()
     {
         _currRenderPass = SDL_BeginGPURenderPass(_currCommandBuffer, &_currColorTarget, 1, nullptr);
+        _uniformArena.ResetBindings();
+        _recordState.ResetBindings();
+        _frameRenderPasses++;
+    }
+
+    void SDLRenderer::BeginRenderPass(const SDLRenderPassNode& pass)
+    {
+        EndRenderPass();
+
+        _currColorTarget = {};
+        _currColorTarget.texture = _currSwapchainTexture;
+        _currColorTarget.clear_color = pass.ClearColor;
+        _currColorTarget.load_op = pass.LoadOp;
+        _currColorTarget.store_op = pass.StoreOp;
+        BeginRenderPass();
     }
 
     void SDLRenderer::EndRenderPass()
@@ -264,152 +1104,166 @@ namespace SDLRendering
     {
         if (_currCommandBuffer)
         {
-            SDL_SubmitGPUCommandBuffer(_currCommandBuffer);
+            // The fence tells later frames when the resources this one used can be released
+            _frameFences.Submit(_currCommandBuffer, _frameIndex);
             _currCommandBuffer = nullptr;
         }
     }
 
     void SDLRenderer::CompileMaterial(const Tbx::DrawCommand& cmd)
     {
-        // Clear any passes to allow for future gpu passes
-        EndRenderPass();
-
-        // Get the current material
         const auto& material = std::any_cast<const Tbx::Material&>(cmd.GetPayload());
-        _currentMaterial = material;
+        if (!_compiledMaterials.insert(material.GetId()).second)
+        {
+            return;
+        }
 
         // Upload, set, and compile shaders (if not already)
-        const auto& vertShader = _currentMaterial.GetVertexShader();
-        const auto& fragShader = _currentMaterial.GetFragmentShader();
-        _shaderCache.Add(vertShader, _device.get());
-        _shaderCache.Add(fragShader, _device.get());
+        const auto& vertShader = material.GetVertexShader();
+        const auto& fragShader = material.GetFragmentShader();
+        const SDLShaderVariant& variant = GetMaterialVariant(material.GetId());
+        _shaderCache.Add(vertShader, variant, _device.get());
+        _shaderCache.Add(fragShader, variant, _device.get());
 
         // Upload textures (if not already)
-        const std::vector<Tbx::Texture>& textures = _currentMaterial.GetTextures();
+        const std::vector<Tbx::Texture>& textures = material.GetTextures();
         for (size_t i = 0; i < textures.size(); i++)
         {
             const Tbx::Texture& texture = textures[i];
-            _textureCache.Add(texture, _device.get(), _currCommandBuffer);
+            _textureCache.Add(texture, _device.get(), _uploadQueue);
         }
     }
 
-    void SDLRenderer::SetMaterial(const Tbx::DrawCommand& cmd)
+    void SDLRenderer::SetMaterial(Uint32 material)
     {
-        auto material = std::any_cast<const Tbx::Material&>(cmd.GetPayload());
+        // Pushed uniforms stay on the command buffer across materials, the arena keeps track of them
         _currentMaterial = material;
-        _shaderUniforms.clear();
-    }
-
-    void SDLRenderer::UploadShaderData(const Tbx::DrawCommand& cmd)
-    {
-        const auto& data = std::any_cast<const Tbx::ShaderData&>(cmd.GetPayload());
-        _shaderUniforms.push_back(data);
-    }
-
-    void SDLRenderer::DrawMesh(const Tbx::DrawCommand& cmd, SDL_Window* window)
-    {
-        const auto& mesh = std::any_cast<const Tbx::Mesh&>(cmd.GetPayload());
-        const Tbx::VertexBuffer& meshVertexBuffer = mesh.GetVertexBuffer();
-        const Tbx::BufferLayout& meshBufferLayout = meshVertexBuffer.GetLayout();
-
-        // get the vertices from the mesh
-        const auto& vertices = meshVertexBuffer.GetVertices();
-        const void* verticesPtr = &vertices[0];
-        const auto verticesSize = static_cast<Uint32>(sizeof(float) * vertices.size());
-
-        // get the indices from the mesh
-        const auto& indices = mesh.GetIndices();
-        const void* indicesPtr = &indices[0];
-        const auto indicesSize = static_cast<Uint32>(sizeof(Tbx::uint32) * indices.size());
-        const auto indexCount = static_cast<Uint32>(indices.size());
-
-        // create the graphics pipeline
-        std::vector<SDL_GPUVertexAttribute> vertexAttributes = SDLCreateVertexAttributes(meshBufferLayout);
-        std::vector<SDL_GPUVertexBufferDescription> vertexBufferDesctiptions = SDLCreateVertexBufferDescriptions(meshBufferLayout);
-        SDL_GPUColorTargetDescription colorTargetDescriptions[1];
-        SDL_GPUGraphicsPipelineCreateInfo graphicsPipelineInfo = {};
-        colorTargetDescriptions[0] = {};
-        colorTargetDescriptions[0].format = SDL_GetGPUSwapchainTextureFormat(_device.get(), window);
-        graphicsPipelineInfo.vertex_shader = _shaderCache.Get(_currentMaterial.GetVertexShader()).Shader;
-        graphicsPipelineInfo.fragment_shader = _shaderCache.Get(_currentMaterial.GetFragmentShader()).Shader;
-        graphicsPipelineInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
-        graphicsPipelineInfo.vertex_input_state.num_vertex_attributes = (Uint32)vertexAttributes.size();
-        graphicsPipelineInfo.vertex_input_state.vertex_attributes = &vertexAttributes[0];
-        graphicsPipelineInfo.vertex_input_state.num_vertex_buffers = (Uint32)vertexBufferDesctiptions.size();
-        graphicsPipelineInfo.vertex_input_state.vertex_buffer_descriptions = &vertexBufferDesctiptions[0];
-        graphicsPipelineInfo.target_info.num_color_targets = 1;
-        graphicsPipelineInfo.target_info.color_target_descriptions = colorTargetDescriptions;
-        //graphicsPipelineInfo.rasterizer_state.cull_mode = SDL_GPU_CULLMODE_NONE;
-        SDL_GPUGraphicsPipeline* graphicsPipeline = SDL_CreateGPUGraphicsPipeline(_device.get(), &graphicsPipelineInfo);
-
-        // create the vertex buffer and upload the vertices
-        SDL_GPUBufferCreateInfo vertexBufferCreateInfo = {};
-        vertexBufferCreateInfo.size = verticesSize;
-        vertexBufferCreateInfo.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-        SDL_GPUBuffer* vertexBuffer = SDLCreateBuffer(vertexBufferCreateInfo, _device.get());
-        SDLUploadBuffer(vertexBuffer, verticesSize, verticesPtr, _device.get(), _currCommandBuffer);
-
-        // create the index buffer and upload the indices
-        SDL_GPUBufferCreateInfo indexBufferCreateInfo = {};
-        indexBufferCreateInfo.size = indicesSize;
-        indexBufferCreateInfo.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-        SDL_GPUBuffer* indexBuffer = SDLCreateBuffer(indexBufferCreateInfo, _device.get());
-        SDLUploadBuffer(indexBuffer, indicesSize, indicesPtr, _device.get(), _currCommandBuffer);
-
-        // Start render pass for the mesh
-        _currColorTarget.load_op = SDL_GPU_LOADOP_LOAD; // don't clear color target
-        BeginRenderPass();
-        SDL_BindGPUGraphicsPipeline(_currRenderPass, graphicsPipeline);
-
-        // bind the vertex buffer
-        SDL_GPUBufferBinding vertexBufferBindings[1];
-        vertexBufferBindings[0] = {};
-        vertexBufferBindings[0].buffer = vertexBuffer;
-        vertexBufferBindings[0].offset = 0;
-        SDL_BindGPUVertexBuffers(_currRenderPass, 0, vertexBufferBindings, 1);
-
-        // bind the index buffer
-        SDL_GPUBufferBinding indexBufferBindings[1];
-        indexBufferBindings[0] = {};
-        indexBufferBindings[0].buffer = indexBuffer;
-        indexBufferBindings[0].offset = 0;
-        SDL_BindGPUIndexBuffer(_currRenderPass, indexBufferBindings, SDL_GPU_INDEXELEMENTSIZE_32BIT);
-
-        // HACK: upload the uniform data to the shaders
-        for (auto i = 0; i < _shaderUniforms.size(); i++)
-        {
-            const auto& shaderData = _shaderUniforms[i];
-            if (shaderData.IsFragment)
+    }
+
+    void SDLRenderer::UploadShaderData(Uint32 uniform)
+    {
+        _uniformArena.Set(uniform, _commandList);
+    }
+
+    void SDLRenderer::DrawMesh(Uint32 mesh, SDL_Window* window, const SDLInstanceBatch* batch)
+    {
+        SDLResolvedDraw draw = {};
+        if (!ResolveDraw(mesh, window, batch, draw))
+        {
+            return;
+        }
+
+        // Start a render pass if one isn't open yet, consecutive draws share it
+        if (_currRenderPass == nullptr)
+        {
+            _currColorTarget.load_op = SDL_GPU_LOADOP_LOAD; // don't clear color target
+            BeginRenderPass();
+        }
+        SDLRecordDraw(draw, _currCommandBuffer, _currRenderPass, _uniformArena, _recordState);
+        TBX_RENDERER_STAT_ADD(_stats, Draws, 1);
+    }
+
+    bool SDLRenderer::ResolveDraw(Uint32 mesh, SDL_Window* window, const SDLInstanceBatch* batch, SDLResolvedDraw& draw)
+    {
+        if (_currentMaterial == SDL_MAX_UINT32)
+        {
+            TBX_ASSERT(false, "Cannot draw a mesh without a material set!");
+            return false;
+        }
+
+        const SDLMeshHandle& meshHandle = _commandList.GetMeshes()[mesh];
+        const SDLMaterialHandle& material = _commandList.GetMaterials()[_currentMaterial];
+        const Tbx::BufferLayout& meshBufferLayout = _commandList.GetLayouts()[meshHandle.Layout];
+
+        // Draw with the fallback material while the material's shaders are still compiling, or skip the draw if there is none
+        Tbx::Uid materialId = material.Id;
+        Tbx::Uid vertexShader = material.VertexShader;
+        Tbx::Uid fragmentShader = material.FragmentShader;
+        const Tbx::Uid* textures = _commandList.GetTextures().data() + material.FirstTexture;
+        Uint32 textureCount = material.TextureCount;
+        Uint32 shaderVariant = GetMaterialVariant(materialId).Id;
+        if (!_shaderCache.IsReady(vertexShader, shaderVariant) || !_shaderCache.IsReady(fragmentShader, shaderVariant))
+        {
+            // A shader that is neither ready nor compiling was evicted or failed, compile the material again next frame
+            const bool vertexMissing = !_shaderCache.IsReady(vertexShader, shaderVariant) && !_shaderCache.IsPending(vertexShader, shaderVariant);
+            const bool fragmentMissing = !_shaderCache.IsReady(fragmentShader, shaderVariant) && !_shaderCache.IsPending(fragmentShader, shaderVariant);
+            if (vertexMissing || fragmentMissing)
             {
-                SDL_PushGPUFragmentUniformData(_currCommandBuffer, shaderData.UniformSlot, shaderData.UniformData, shaderData.UniformSize);
+                _compiledMaterials.erase(materialId);
             }
-            else
+
+
+            if (!_hasFallbackMaterial)
             {
-                SDL_PushGPUVertexUniformData(_currCommandBuffer, shaderData.UniformSlot, shaderData.UniformData, shaderData.UniformSize);
+                return false;
             }
+
+            materialId = _fallbackMaterial;
+            vertexShader = _fallbackVertexShader;
+            fragmentShader = _fallbackFragmentShader;
+            textures = _fallbackTextures.data();
+            textureCount = static_cast<Uint32>(_fallbackTextures.size());
+            shaderVariant = GetMaterialVariant(materialId).Id;
         }
 
-        // bind the textures to the fragment shader
-        const auto& textures = _currentMaterial.GetTextures();
-        for (size_t i = 0; i < textures.size(); i++)
+        // the mesh was made resident by StageUploads, unless it had no data or its buffers couldn't be created
+        const SDLCachedMesh* cachedMesh = _meshCache.Get(meshHandle.Id);
+        if (cachedMesh == nullptr)
         {
-            const auto& texture = textures[i];
-            auto& cachedTexture = _textureCache.Get(texture);
-            if (cachedTexture.Sampler != nullptr && cachedTexture.Texture != nullptr)
+            return false;
+        }
+
+        // get the graphics pipeline, it is only created the first time this state combination is seen
+        SDLPipelineKey pipelineKey = {};
+        pipelineKey.VertexShader = vertexShader;
+        pipelineKey.FragmentShader = fragmentShader;
+        pipelineKey.ShaderVariant = shaderVariant;
+        pipelineKey.Layout = meshHandle.Layout;
+        pipelineKey.InstanceStride = batch != nullptr ? batch->InstanceStride : 0;
+        pipelineKey.ColorFormat = SDL_GetGPUSwapchainTextureFormat(_device.get(), window);
+        pipelineKey.BlendEnabled = _blendedMaterials.contains(materialId);
+        const SDLCachedShader& cachedVertexShader = _shaderCache.Get(vertexShader, shaderVariant);
+        const SDLCachedShader& cachedFragmentShader = _shaderCache.Get(fragmentShader, shaderVariant);
+        draw.Pipeline = _pipelineCache.GetOrCreate(
+            pipelineKey,
+            meshBufferLayout,
+            cachedVertexShader.Shader,
+            cachedFragmentShader.Shader,
+            _device.get());
+
+        draw.VertexBuffer = cachedMesh->VertexBuffer;
+        draw.IndexBuffer = cachedMesh->IndexBuffer;
+        draw.IndexCount = cachedMesh->IndexCount;
+        if (batch != nullptr)
+        {
+            draw.InstanceBuffer = _instanceBatcher.GetInstanceBuffer();
+            draw.InstanceOffset = batch->InstanceOffset;
+            draw.InstanceCount = batch->InstanceCount;
+        }
+        draw.VertexBindings = cachedVertexShader.Bindings;
+        draw.FragmentBindings = cachedFragmentShader.Bindings;
+
+        // the textures the fragment shader samples, up to the first one that isn't resident
+        const Uint32 samplerCount = SDL_min(SDL_min(textureCount, cachedFragmentShader.Bindings.NumSamplers), SDLResolvedDraw::MaxSamplersPerStage);
+        for (; draw.SamplerCount < samplerCount; draw.SamplerCount++)
+        {
+            const Tbx::Uid& texture = textures[draw.SamplerCount];
+            const auto& cachedTexture = _textureCache.Get(texture);
+            if (_textureCache.GetResidency(texture) == SDLTextureResidency::Missing)
             {
-                SDL_GPUTextureSamplerBinding textureSamplerBinding = {};
-                textureSamplerBinding.texture = cachedTexture.Texture;
-                textureSamplerBinding.sampler = cachedTexture.Sampler;
-                SDL_BindGPUFragmentSamplers(_currRenderPass, static_cast<Uint32>(i), &textureSamplerBinding, 1);
+                // Evicted or removed since the material was compiled, it is added again next frame
+                _compiledMaterials.erase(materialId);
+            }
+            if (cachedTexture.Sampler == nullptr || cachedTexture.Texture == nullptr)
+            {
+                break;
             }
-        }
 
-        // draw the mesh
-        SDL_DrawGPUIndexedPrimitives(_currRenderPass, indexCount, 1, 0, 0, 0);
+            draw.Samplers[draw.SamplerCount] = {};
+            draw.Samplers[draw.SamplerCount].texture = cachedTexture.Texture;
+            draw.Samplers[draw.SamplerCount].sampler = cachedTexture.Sampler;
+        }
 
-        // release the resources created above
-        SDL_ReleaseGPUGraphicsPipeline(_device.get(), graphicsPipeline);
-        SDL_ReleaseGPUBuffer(_device.get(), indexBuffer);
-        SDL_ReleaseGPUBuffer(_device.get(), vertexBuffer);
+        return true;
     }
 }
@@ -1,14 +1,36 @@
 #pragma once
 #include "SDLTexture.h"
 #include "SDLShader.h"
+#include "SDLPipeline.h"
+#include "SDLMesh.h"
+#include "SDLFrameGraph.h"
+#include "SDLInstancing.h"
+#include "SDLDrawSort.h"
+#include "SDLCommandList.h"
+#include "SDLUniforms.h"
+#include "SDLFrameSync.h"
+#include "SDLParallelRecorder.h"
+#include "SDLFrameQueue.h"
+#include "SDLRenderStats.h"
 #include <SDL3/SDL.h>
 #include <Tbx/Graphics/IRenderer.h>
 #include <Tbx/Graphics/Material.h>
 #include <Tbx/Graphics/Mesh.h>
 #include <map>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace SDLRendering
 {
+    enum class SDLSwapchainAcquireMode
+    {
+        // Waits for a swapchain texture, the game loop is held back whenever the GPU falls behind
+        Blocking,
+        // Never waits, Draw skips the frame while the GPU still has every allowed frame in flight
+        NonBlocking
+    };
+
     class SDLRenderer : public Tbx::IRenderer
     {
     public:
@@ -28,31 +50,196 @@ namespace SDLRendering
         void SetResolution(const Tbx::Size& size) override;
         const Tbx::Size& GetResolution() override;
 
+        // Requests VSYNC when enabled, otherwise MAILBOX. Reports what was requested, not what the window ended up with.
         void SetVSyncEnabled(bool enabled) override;
         bool GetVSyncEnabled() override;
 
+        // Falls back to IMMEDIATE and then VSYNC when the window doesn't support the mode. The requested mode is kept
+        // and retried whenever the swapchain is set up again, GetAppliedPresentMode is the one actually presenting.
+        void SetPresentMode(SDL_GPUPresentMode mode);
+        SDL_GPUPresentMode GetPresentMode() const { return _requestedPresentMode; }
+        SDL_GPUPresentMode GetAppliedPresentMode() const { return _appliedPresentMode; }
+
+        // How many frames the CPU may record ahead of the GPU, 1 for the lowest latency up to 3 for the most throughput
+        void SetFramesInFlight(Uint32 count);
+        Uint32 GetFramesInFlight() const { return _framesInFlight; }
+
+        void SetSwapchainAcquireMode(SDLSwapchainAcquireMode mode);
+        SDLSwapchainAcquireMode GetSwapchainAcquireMode() const { return _swapchainAcquireMode; }
+
+        // Frames Draw skipped because no swapchain texture was available
+        Uint64 GetSkippedFrameCount() const { return _skippedFrames; }
+
+        // Draws on a dedicated thread, Draw then only copies the frame buffer into a queue of slotCount (2 or 3) frames and returns.
+        // The backpressure policy decides what Draw does when the render thread is slotCount frames behind, the skip policy
+        // whether the render thread draws every queued frame or only the newest. While the thread runs, Draw and Flush are the
+        // only calls that may be made without waiting for it first, Flush waits until every queued frame has been drawn.
+        void SetRenderThread(bool enabled, Uint32 slotCount = 3, SDLFrameBackpressure backpressure = SDLFrameBackpressure::Block, SDLFrameSkip skip = SDLFrameSkip::None);
+        bool GetRenderThreadEnabled() const { return _renderThread.joinable(); }
+
+        // Frames Draw dropped because the queue was full, and queued frames the render thread skipped as stale
+        Uint64 GetDroppedFrameCount() const { return _frameQueue.GetDroppedCount(); }
+        Uint64 GetStaleFrameCount() const { return _frameQueue.GetSkippedCount(); }
+
         void Flush() override;
         void Clear(const Tbx::Color& color) override;
         void Draw(const Tbx::FrameBuffer& buffer) override;
 
-        void DrawMesh(const Tbx::DrawCommand& cmd, SDL_Window* window);
+        void StageUploads(const Tbx::FrameBuffer& buffer);
+        void DrawPasses(SDL_Window* window);
+        void DrawPassesSorted(SDL_Window* window);
+        void DrawPassesParallel(SDL_Window* window);
 
-        void UploadShaderData(const Tbx::DrawCommand& cmd);
+        void DrawMesh(Uint32 mesh, SDL_Window* window, const SDLInstanceBatch* batch = nullptr);
 
-        void SetMaterial(const Tbx::DrawCommand& cmd);
+        void UploadShaderData(Uint32 uniform);
 
+        void SetMaterial(Uint32 material);
+
+        // Compiles the material the first time it is seen, again only after a draw found one of its shaders or textures gone
         void CompileMaterial(const Tbx::DrawCommand& cmd);
 
 
         bool TryBeginDraw(SDL_Window* window);
         void BeginRenderPass();
+        void BeginRenderPass(const SDLRenderPassNode& pass);
         void EndDraw();
 
         void SubmitCommandBuffer();
 
         void EndRenderPass();
 
+        // When enabled, runs of draws sharing mesh and material are merged into instanced draws, see SDLInstanceBatcher
+        void SetInstancingEnabled(bool enabled);
+        bool GetInstancingEnabled() const;
+
+        // Marks the material's vertex shader as reading its vertex uniforms as per-instance float4 inputs,
+        // only such materials are instanced
+        void SetMaterialInstanced(const Tbx::Uid& material, bool instanced);
+
+        // When enabled, draws are submitted in state key order instead of submission order, see SDLDrawSorter.
+        // Sorting takes precedence over instancing, which is skipped while sorting is on.
+        void SetSortingEnabled(bool enabled);
+        bool GetSortingEnabled() const;
+
+        // Transparent materials' draws always keep submission order, this only affects sorting
+        void SetMaterialTransparent(const Tbx::Uid& material, bool transparent);
+
+        // Blended materials are drawn with alpha blending, independent of whether they are transparent
+        void SetMaterialBlended(const Tbx::Uid& material, bool blended);
+
+        // Converts textures on worker threads and spreads their uploads over frames, uploading at most
+        // bytesPerFrame each frame (0 is unlimited). A placeholder is bound until a texture is resident, 0 workers uploads inline.
+        void SetTextureStreaming(Uint32 workerCount, Uint32 bytesPerFrame);
+        SDLTextureResidency GetTextureResidency(const Tbx::Uid& texture) const;
+        Uint32 GetStreamingTextureCount() const;
+
+        // How mip chains are built for textures uploaded from now on, GPU generation by default.
+        // The per texture mode overrides the default, i.e. None opts a texture out of mips entirely.
+        void SetDefaultMipmapMode(SDLMipmapMode mode);
+        void SetTextureMipmapMode(const Tbx::Uid& texture, SDLMipmapMode mode);
+
+        // Block compresses textures uploaded from now on, encoded blocks are cached on disk by texture content
+        void SetDefaultTextureCompression(SDLTextureCompression compression);
+        void SetTextureCompression(const Tbx::Uid& texture, SDLTextureCompression compression);
+
+        // Packs small textures of the same size into shared array textures so draws using them keep the same binding,
+        // the texture's shader has to sample an array at GetTextureLayer. Packing applies to textures uploaded from now on.
+        // A texture set to be packed is always bound as an array, layer 0 of an array placeholder until it is resident.
+        void SetTextureArrayPacking(const Tbx::Uid& texture, bool packed);
+        void SetTextureArrayPackingLimits(Uint32 maxSize, Uint32 layerCount);
+        Uint32 GetTextureLayer(const Tbx::Uid& texture);
+
+        // Whether the resident texture actually is an array layer, i.e. false for one uploaded before packing was turned on
+        bool IsTexturePacked(const Tbx::Uid& texture) const { return _textureCache.IsPacked(texture); }
+
+        // Textures with the same filter and wrap share a sampler, these count the distinct samplers alive
+        // and how many have been created in total
+        Uint32 GetSamplerCount() const { return _textureCache.GetSamplerCache().GetSamplerCount(); }
+        Uint64 GetSamplerCreationCount() const { return _textureCache.GetSamplerCache().GetCreatedCount(); }
+
+        // Memory the texture and shader caches may hold before the least recently used entries are evicted, 0 is unlimited.
+        // Evicted and removed resources are released once the frames using them have completed, and re-uploaded when drawn again.
+        void SetTextureMemoryBudget(Uint64 bytes);
+        void SetShaderMemoryBudget(Uint64 bytes);
+        void RemoveTexture(const Tbx::Uid& texture);
+        void RemoveShader(const Tbx::Uid& shader);
+
+        Uint64 GetTextureResidentBytes() const { return _textureCache.GetResidentBytes(); }
+        Uint64 GetShaderResidentBytes() const { return _shaderCache.GetResidentBytes(); }
+        Uint64 GetTextureEvictionCount() const { return _textureCache.GetEvictionCount(); }
+        Uint64 GetShaderEvictionCount() const { return _shaderCache.GetEvictionCount(); }
+
+        // Vertex, index, instance and storage buffers come from a size classed pool and are recycled once the
+        // frames using them have completed, these count the buffers created and the acquisitions served from the pool
+        Uint64 GetBufferCreationCount() const { return _bufferPool.GetCreatedCount(); }
+        Uint64 GetBufferReuseCount() const { return _bufferPool.GetReusedCount(); }
+        Uint64 GetPooledBufferBytes() const { return _bufferPool.GetPooledBytes(); }
+
+        // Records the frame's draws on worker threads, drawsPerChunk draws to a command buffer, 0 workers records on the calling thread.
+        // Draws are resolved up front and recorded into an offscreen target that is copied to the swapchain, in submission order
+        // or sorted order as usual. Passes start a new chunk, a pass with more draws than a chunk spans several.
+        void SetParallelRecording(Uint32 workerCount, Uint32 drawsPerChunk = 256);
+        Uint32 GetParallelRecordingWorkers() const { return _parallelRecorder.GetWorkerCount(); }
+
+        // Meshes are uploaded again when their data changes. An edit that keeps the size is found by re-hashing resident meshes
+        // within a per frame byte budget, marking the mesh dirty gets it hashed on its next draw instead.
+        void MarkMeshDirty(const Tbx::Uid& mesh);
+        void SetMeshVerificationBudget(Uint64 bytesPerFrame);
+
+        // Uniform blocks bigger than this many bytes are uploaded into storage buffers instead of pushed, 0 turns it off
+        void SetUniformStorageThreshold(Uint32 size);
+
+        // Uniform slots pushed by the last frame, and uploads skipped because the slot already held the data
+        Uint32 GetUniformPushCount() const { return _uniformArena.GetPushCount() + _frameParallelUniformPushes; }
+        Uint32 GetUniformSkippedCount() const { return _uniformArena.GetSkippedCount(); }
+
+        // Compiles the material's shaders with the given defines ("NAME" or "NAME=VALUE") instead of the plain source,
+        // so features can be compiled out rather than branched on at runtime. An empty list restores the default variant.
+        void SetMaterialDefines(const Tbx::Uid& material, const std::vector<std::string>& defines);
+
+        // Compiles new shaders on worker threads instead of stalling the frame, 0 compiles them inline.
+        // Draws whose shaders aren't ready yet use the fallback material or are skipped if there is none.
+        void SetAsyncShaderCompilation(Uint32 workerCount);
+        void SetFallbackMaterial(const Tbx::Material& material);
+
+        // Shader compilations that haven't finished yet, i.e. for loading screens to wait on
+        Uint32 GetPendingShaderCompilations() const;
+
+        // Pipeline, material and texture changes avoided by sorting the last frame
+        Uint32 GetStateChangesSaved() const;
+
+        // The lowered form of the last frame buffer drawn, reused as is while the frame buffer doesn't change
+        const SDLCommandList& GetCommandList() const { return _commandList; }
+
+        // Number of passes recorded by the last call to Draw
+        Uint32 GetCopyPassCount() const { return _frameCopyPasses; }
+        Uint32 GetRenderPassCount() const { return _frameRenderPasses; }
+
+        // Per frame counts and CPU timings of the last frames drawn, only recorded when built with TBX_RENDERER_STATS.
+        // With the render thread on, read them after Flush so the render thread isn't writing them.
+        const SDLRenderStats& GetStats() const { return _stats; }
+        void SetStatsHistorySize(Uint32 frameCount) { _stats.SetHistorySize(frameCount); }
+
+        // Fragment sampler binds issued by the last call to Draw, draws whose textures are already bound skip theirs
+        Uint32 GetTextureBindCount() const { return _recordState.TextureBinds; }
+
     private:
+        const SDLShaderVariant& GetMaterialVariant(const Tbx::Uid& material) const;
+        void ApplySwapchainParameters();
+
+        void DrawFrame(const Tbx::FrameBuffer& buffer, const Tbx::Color& clearColor);
+        bool RecordFrame(const Tbx::FrameBuffer& buffer, const Tbx::Color& clearColor);
+        void RecordFrameStats(bool skipped);
+        void RenderThreadLoop();
+        void StopRenderThread();
+
+        // Looks up everything the draw needs to be recorded, false if it has to be skipped
+        bool ResolveDraw(Uint32 mesh, SDL_Window* window, const SDLInstanceBatch* batch, SDLResolvedDraw& draw);
+
+        // The texture parallel recording renders into, recreated whenever the swapchain's size or format changes
+        SDL_GPUTexture* GetParallelTarget(SDL_Window* window);
+
         std::shared_ptr<SDL_GPUDevice> _device = nullptr;
         std::shared_ptr<Tbx::IRenderSurface> _surface = nullptr;
 
@@ -62,18 +249,73 @@ namespace SDLRendering
 
         SDL_GPUColorTargetInfo _currColorTarget;
 
+        // What the current render pass has bound
+        SDLRecordState _recordState;
+
+        // Declared before everything that releases into them
+        SDLReleaseQueue _releaseQueue;
+        SDLBufferPool _bufferPool;
+
+        SDLCommandList _commandList;
+        SDLPipelineCache _pipelineCache;
+        SDLFrameGraph _frameGraph;
+        SDLInstanceBatcher _instanceBatcher;
+        SDLDrawSorter _drawSorter;
+        SDLUniformArena _uniformArena;
+        SDLUploadQueue _uploadQueue;
+        SDLMeshCache _meshCache;
         SDLTextureCache _textureCache;
         SDLShaderCache _shaderCache;
+        SDLFrameFences _frameFences;
+        SDLParallelRecorder _parallelRecorder;
+        SDLFrameQueue _frameQueue;
+        SDLRenderStats _stats;
+        std::thread _renderThread;
+
+        std::vector<SDLResolvedDraw> _resolvedDraws;
+        std::vector<SDLRecordChunk> _recordChunks;
+        SDL_GPUTexture* _parallelTarget = nullptr;
+        SDL_GPUTextureFormat _parallelTargetFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+        Uint32 _parallelTargetWidth = 0;
+        Uint32 _parallelTargetHeight = 0;
+        Uint32 _drawsPerChunk = 256;
+
+        // Handles into _commandList
+        Uint32 _currentMaterial = SDL_MAX_UINT32;
+        std::unordered_set<Tbx::Uid> _transparentMaterials;
+        std::unordered_set<Tbx::Uid> _blendedMaterials;
+        std::unordered_set<Tbx::Uid> _instancedMaterials;
+        std::unordered_map<Tbx::Uid, SDLShaderVariant> _materialVariants;
+        SDLShaderVariantTable _shaderVariants;
+        std::unordered_set<Tbx::Uid> _compiledMaterials;
 
-        Tbx::Material _currentMaterial;
-        std::vector<Tbx::ShaderData> _shaderUniforms;
+        Tbx::Uid _fallbackMaterial;
+        Tbx::Uid _fallbackVertexShader;
+        Tbx::Uid _fallbackFragmentShader;
+        std::vector<Tbx::Uid> _fallbackTextures;
+        bool _hasFallbackMaterial = false;
 
         Tbx::Size _resolution = { 0,0 };
         Tbx::Viewport _viewport = { { 0,0 }, { 0,0 } };
 
         Tbx::GraphicsApi _api = Tbx::GraphicsApi::None;
 
-        bool _vsyncEnabled = false;
+        SDL_GPUPresentMode _requestedPresentMode = SDL_GPU_PRESENTMODE_VSYNC;
+        SDL_GPUPresentMode _appliedPresentMode = SDL_GPU_PRESENTMODE_VSYNC;
+        SDLSwapchainAcquireMode _swapchainAcquireMode = SDLSwapchainAcquireMode::Blocking;
+        Uint32 _framesInFlight = 2;
+        bool _instancingEnabled = false;
+        bool _sortingEnabled = false;
+
+        // Counts frames from 1, resources used by a frame are released once its fence has signaled
+        Uint64 _frameIndex = 0;
+        Uint64 _skippedFrames = 0;
+        Uint32 _swapchainWidth = 0;
+        Uint32 _swapchainHeight = 0;
+
+        Uint32 _frameCopyPasses = 0;
+        Uint32 _frameRenderPasses = 0;
+        Uint32 _frameParallelUniformPushes = 0;
     };
 }
 
@@ -0,0 +1,105 @@
+#include "SDLSampler.h"
+#include "SDLPipeline.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    size_t SDLSamplerInfoHasher::operator()(const SDL_GPUSamplerCreateInfo& info) const
+    {
+        size_t seed = 0;
+        SDLHashCombine(seed, static_cast<size_t>(info.min_filter));
+        SDLHashCombine(seed, static_cast<size_t>(info.mag_filter));
+        SDLHashCombine(seed, static_cast<size_t>(info.mipmap_mode));
+        SDLHashCombine(seed, static_cast<size_t>(info.address_mode_u));
+        SDLHashCombine(seed, static_cast<size_t>(info.address_mode_v));
+        SDLHashCombine(seed, static_cast<size_t>(info.address_mode_w));
+        SDLHashCombine(seed, std::hash<float>()(info.mip_lod_bias));
+        SDLHashCombine(seed, std::hash<float>()(info.max_anisotropy));
+        SDLHashCombine(seed, static_cast<size_t>(info.compare_op));
+        SDLHashCombine(seed, std::hash<float>()(info.min_lod));
+        SDLHashCombine(seed, std::hash<float>()(info.max_lod));
+        SDLHashCombine(seed, static_cast<size_t>(info.enable_anisotropy));
+        SDLHashCombine(seed, static_cast<size_t>(info.enable_compare));
+        SDLHashCombine(seed, static_cast<size_t>(info.props));
+        return seed;
+    }
+
+    bool SDLSamplerInfoEqual::operator()(const SDL_GPUSamplerCreateInfo& a, const SDL_GPUSamplerCreateInfo& b) const
+    {
+        // Compared field by field, the struct has padding so it can't be compared as bytes
+        return a.min_filter == b.min_filter &&
+            a.mag_filter == b.mag_filter &&
+            a.mipmap_mode == b.mipmap_mode &&
+            a.address_mode_u == b.address_mode_u &&
+            a.address_mode_v == b.address_mode_v &&
+            a.address_mode_w == b.address_mode_w &&
+            a.mip_lod_bias == b.mip_lod_bias &&
+            a.max_anisotropy == b.max_anisotropy &&
+            a.compare_op == b.compare_op &&
+            a.min_lod == b.min_lod &&
+            a.max_lod == b.max_lod &&
+            a.enable_anisotropy == b.enable_anisotropy &&
+            a.enable_compare == b.enable_compare &&
+            a.props == b.props;
+    }
+
+    SDLSamplerCache::~SDLSamplerCache()
+    {
+        Clear();
+    }
+
+    SDL_GPUSampler* SDLSamplerCache::Acquire(const SDL_GPUSamplerCreateInfo& info, SDL_GPUDevice* device)
+    {
+        const auto i = _samplers.find(info);
+        if (i != _samplers.end())
+        {
+            i->second.RefCount++;
+            return i->second.Sampler;
+        }
+
+        SDL_GPUSampler* sampler = SDL_CreateGPUSampler(device, &info);
+        if (sampler == nullptr)
+        {
+            TBX_ASSERT(false, "Failed to create sampler: {}", SDL_GetError());
+            return nullptr;
+        }
+        _createdCount++;
+
+        Entry entry = {};
+        entry.Sampler = sampler;
+        entry.Device = device;
+        entry.RefCount = 1;
+        _samplers.emplace(info, entry);
+        _samplerInfos.emplace(sampler, info);
+        return sampler;
+    }
+
+    void SDLSamplerCache::Release(SDL_GPUSampler* sampler)
+    {
+        const auto info = _samplerInfos.find(sampler);
+        if (info == _samplerInfos.end())
+        {
+            return;
+        }
+
+        const auto i = _samplers.find(info->second);
+        if (--i->second.RefCount > 0)
+        {
+            return;
+        }
+
+        SDL_ReleaseGPUSampler(i->second.Device, i->second.Sampler);
+        _samplers.erase(i);
+        _samplerInfos.erase(info);
+    }
+
+    void SDLSamplerCache::Clear()
+    {
+        for (const auto& [info, entry] : _samplers)
+        {
+            SDL_ReleaseGPUSampler(entry.Device, entry.Sampler);
+        }
+        _samplers.clear();
+        _samplerInfos.clear();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <unordered_map>
+
+namespace SDLRendering
+{
+    struct SDLSamplerInfoHasher
+    {
+        size_t operator()(const SDL_GPUSamplerCreateInfo& info) const;
+    };
+
+    struct SDLSamplerInfoEqual
+    {
+        bool operator()(const SDL_GPUSamplerCreateInfo& a, const SDL_GPUSamplerCreateInfo& b) const;
+    };
+
+    // Shares one sampler object between everything created with the same sampler state.
+    // Samplers are reference counted, Acquire adds a reference and Release drops one, the
+    // sampler is destroyed with its last reference.
+    struct SDLSamplerCache
+    {
+    public:
+        ~SDLSamplerCache();
+
+        SDL_GPUSampler* Acquire(const SDL_GPUSamplerCreateInfo& info, SDL_GPUDevice* device);
+        void Release(SDL_GPUSampler* sampler);
+
+        void Clear();
+
+        // Samplers alive right now, and samplers created since the cache was made
+        Uint32 GetSamplerCount() const { return static_cast<Uint32>(_samplers.size()); }
+        Uint64 GetCreatedCount() const { return _createdCount; }
+
+    private:
+        struct Entry
+        {
+            SDL_GPUSampler* Sampler = nullptr;
+            SDL_GPUDevice* Device = nullptr;
+            Uint32 RefCount = 0;
+        };
+
+        std::unordered_map<SDL_GPUSamplerCreateInfo, Entry, SDLSamplerInfoHasher, SDLSamplerInfoEqual> _samplers;
+        std::unordered_map<SDL_GPUSampler*, SDL_GPUSamplerCreateInfo> _samplerInfos;
+        Uint64 _createdCount = 0;
+    };
+}
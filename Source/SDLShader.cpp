@@ -1,13 +1,18 @@
 #include "SDLShader.h"
 #include "SDLRenderer.h"
 #include <Tbx/Debug/Debugging.h>
-#include <SDL3_shadercross/SDL_shadercross.h>
+#include <algorithm>
 
 namespace SDLRendering
 {
-    SDLCachedShader::SDLCachedShader(SDL_GPUShader* shader, SDL_GPUDevice* device)
+    // Frames before a failed shader is tried again, doubled for every further failure up to 64 times as long
+    static constexpr Uint64 ShaderRetryDelay = 30;
+    static constexpr Uint32 ShaderRetryMaxDoublings = 6;
+
+    SDLCachedShader::SDLCachedShader(SDL_GPUShader* shader, const SDLShaderBindings& bindings, SDL_GPUDevice* device)
     {
         Shader = shader;
+        Bindings = bindings;
         Device = device;
     }
 
@@ -20,98 +25,302 @@ namespace SDLRendering
         }
     }
 
+    size_t SDLShaderVariantKeyHasher::operator()(const SDLShaderVariantKey& key) const
+    {
+        size_t seed = std::hash<Tbx::Uid>()(key.Shader);
+        SDLHashCombine(seed, static_cast<size_t>(key.Variant));
+        return seed;
+    }
+
     SDLShaderCache::~SDLShaderCache()
     {
+        _compiler.Stop();
         Clear();
     }
 
-    void SDLShaderCache::Add(const Tbx::Shader& shader, SDL_GPUDevice* device)
+    void SDLShaderCache::Add(const Tbx::Shader& shader, SDL_GPUDevice* device, bool allowAsync)
     {
-        const auto i = _cachedShaders.find(shader.GetId());
+        Add(shader, SDLShaderVariant(), device, allowAsync);
+    }
+
+    void SDLShaderCache::Add(const Tbx::Shader& shader, const SDLShaderVariant& variant, SDL_GPUDevice* device, bool allowAsync)
+    {
+        const SDLShaderVariantKey key = { shader.GetId(), variant.Id };
+        const auto i = _cachedShaders.find(key);
+        if (i != _cachedShaders.end())
+        {
+            i->second.LastUsedFrame = _frameIndex;
+            return;
+        }
+        if (_pendingShaders.contains(key))
+        {
+            return;
+        }
+        const auto failed = _failedShaders.find(key);
+        if (failed != _failedShaders.end() && _frameIndex < failed->second.RetryFrame)
+        {
+            return;
+        }
+
+        const auto& shaderType = shader.GetType();
+        if (shaderType != Tbx::ShaderType::Vertex && shaderType != Tbx::ShaderType::Fragment)
+        {
+            TBX_ASSERT(false, "Unsupported shader type: {}", (int)shaderType);
+            return;
+        }
+
+        // Hand the compilation to the workers, the shader becomes available once ProcessCompleted picks it up
+        if (allowAsync && _compiler.IsRunning())
+        {
+            SDLShaderCompileJob job = {};
+            job.Id = shader.GetId();
+            job.Type = shaderType;
+            job.Source = shader.GetSource();
+            job.Variant = variant;
+            _compiler.Enqueue(std::move(job));
+            _pendingShaders.insert(key);
+            return;
+        }
+
+        std::vector<Uint8> spirv = {};
+        if (!SDLCompileSPIRV(shader.GetSource(), shaderType, variant, &_diskCache, spirv))
+        {
+            TBX_ASSERT(false, "Failed to compile shader: {}", SDL_GetError());
+            RecordFailure(key);
+            return;
+        }
+
+        Insert(key, spirv, shaderType, device);
+    }
+
+    const SDLCachedShader& SDLShaderCache::Get(const Tbx::Uid& shader, Uint32 variant)
+    {
+        static const SDLCachedShader missingShader = {};
+
+        const auto i = _cachedShaders.find({ shader, variant });
         if (i == _cachedShaders.end())
         {
-#ifdef TBX_DEBUG
-            auto debug = true;
-#else
-            auto debug = false;
-#endif
-            const auto entryPointFunc = "main";
+            return missingShader;
+        }
+        i->second.LastUsedFrame = _frameIndex;
+        return i->second;
+    }
 
-            SDL_ShaderCross_ShaderStage stage;
-            const auto& shaderType = shader.GetType();
-            if (shaderType == Tbx::ShaderType::Vertex)
+    bool SDLShaderCache::IsReady(const Tbx::Uid& shader, Uint32 variant) const
+    {
+        const auto i = _cachedShaders.find({ shader, variant });
+        return i != _cachedShaders.end() && i->second.Shader != nullptr;
+    }
+
+    bool SDLShaderCache::IsPending(const Tbx::Uid& shader, Uint32 variant) const
+    {
+        return _pendingShaders.contains({ shader, variant });
+    }
+
+    void SDLShaderCache::Remove(const Tbx::Uid& shader)
+    {
+        // Results of compilations still running are ignored once they are no longer pending
+        std::erase_if(_pendingShaders, [&shader](const SDLShaderVariantKey& key) { return key.Shader == shader; });
+        std::erase_if(_failedShaders, [&shader](const auto& failed) { return failed.first.Shader == shader; });
+
+        bool removed = false;
+        for (auto i = _cachedShaders.begin(); i != _cachedShaders.end();)
+        {
+            if (i->first.Shader == shader)
             {
-                stage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+                auto next = std::next(i);
+                Retire(i);
+                i = next;
+                removed = true;
             }
-            else if (shaderType == Tbx::ShaderType::Fragment)
+            else
             {
-                stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+                ++i;
             }
-            else
+        }
+
+        if (removed && _onEvicted)
+        {
+            _onEvicted(shader);
+        }
+    }
+
+    void SDLShaderCache::BeginFrame(Uint64 frame, Uint64 completedFrame)
+    {
+        _frameIndex = frame;
+
+        std::erase_if(_retiredShaders, [completedFrame](const RetiredShader& retired)
+        {
+            return retired.Frame <= completedFrame;
+        });
+
+        if (_memoryBudget == 0 || _residentBytes <= _memoryBudget)
+        {
+            return;
+        }
+
+        // Least recently used first, anything the previous frame drew with stays
+        std::vector<std::pair<Uint64, SDLShaderVariantKey>> candidates = {};
+        for (const auto& [key, cachedShader] : _cachedShaders)
+        {
+            if (cachedShader.LastUsedFrame + 1 < frame && !_pinnedShaders.contains(key.Shader))
             {
-                TBX_ASSERT(false, "Unsupported shader type: {}", (int)shaderType);
-                return;
+                candidates.emplace_back(cachedShader.LastUsedFrame, key);
             }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
 
-            SDL_ShaderCross_HLSL_Info info = {};
-            info.source = shader.GetSource().c_str();
-            info.entrypoint = entryPointFunc;
-            info.shader_stage = stage;
-            info.enable_debug = debug;
-            info.include_dir = nullptr;
-            info.defines = nullptr;
-            info.name = nullptr;
-
-            size_t size = 0;
-            void* data = SDL_ShaderCross_CompileSPIRVFromHLSL(&info, &size);
-            TBX_ASSERT(data != nullptr && size != 0, "Failed to compile shader: {}", SDL_GetError());
-
-            SDL_ShaderCross_SPIRV_Info vertexInfo = {};
-            vertexInfo.entrypoint = entryPointFunc;
-            vertexInfo.bytecode = (Uint8*)data;
-            vertexInfo.bytecode_size = size;
-            vertexInfo.shader_stage = stage;
-            vertexInfo.enable_debug = debug;
-
-            SDL_ShaderCross_GraphicsShaderMetadata shaderMetadata = {};
-            shaderMetadata.num_uniform_buffers = 1;
-            shaderMetadata.num_storage_textures = 0;
-            shaderMetadata.num_storage_buffers = 0;
-            shaderMetadata.num_inputs = 0;
-            shaderMetadata.num_outputs = 0;
-            shaderMetadata.inputs = nullptr;
-            shaderMetadata.outputs = nullptr;
-            if (shaderType == Tbx::ShaderType::Vertex)
+        for (const auto& [lastUsedFrame, key] : candidates)
+        {
+            if (_residentBytes <= _memoryBudget)
             {
-                shaderMetadata.num_samplers = 0;
+                break;
             }
-            else if (shaderType == Tbx::ShaderType::Fragment)
+            Retire(_cachedShaders.find(key));
+            _evictionCount++;
+
+            if (_onEvicted)
             {
-                shaderMetadata.num_samplers = 1;
+                _onEvicted(key.Shader);
             }
+        }
+    }
+
+    void SDLShaderCache::SetMemoryBudget(Uint64 bytes)
+    {
+        _memoryBudget = bytes;
+    }
 
-            SDL_GPUShader* compiledShader = SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(device, &vertexInfo, &shaderMetadata, 0);
-            TBX_ASSERT(compiledShader != nullptr && size != 0, "Failed to compile shader: {}", SDL_GetError());
+    void SDLShaderCache::SetPinned(const Tbx::Uid& shader, bool pinned)
+    {
+        if (pinned)
+        {
+            _pinnedShaders.insert(shader);
+        }
+        else
+        {
+            _pinnedShaders.erase(shader);
+        }
+    }
 
-            _cachedShaders.emplace(
-                std::piecewise_construct,
-                std::forward_as_tuple(shader.GetId()),
-                std::forward_as_tuple(compiledShader, device));
-            SDL_free(data);
+    bool SDLShaderCache::Insert(const SDLShaderVariantKey& key, const std::vector<Uint8>& spirv, Tbx::ShaderType type, SDL_GPUDevice* device)
+    {
+        SDLShaderBindings bindings = {};
+        SDL_GPUShader* compiledShader = SDLCreateShaderFromSPIRV(spirv, type, device, bindings);
+        if (compiledShader == nullptr)
+        {
+            TBX_TRACE_ERROR("Failed to create shader: {}", SDL_GetError());
+            RecordFailure(key);
+            return false;
         }
+
+        _failedShaders.erase(key);
+        auto [i, inserted] = _cachedShaders.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(compiledShader, bindings, device));
+
+        i->second.Size = spirv.size();
+        i->second.LastUsedFrame = _frameIndex;
+        _residentBytes += spirv.size();
+        _createdCount++;
+        return true;
+    }
+
+    void SDLShaderCache::RecordFailure(const SDLShaderVariantKey& key)
+    {
+        FailedShader& failed = _failedShaders[key];
+        const Uint64 delay = ShaderRetryDelay << SDL_min(failed.Attempts, ShaderRetryMaxDoublings);
+        failed.Attempts++;
+        failed.RetryFrame = _frameIndex + delay;
     }
 
-    const SDLCachedShader& SDLShaderCache::Get(const Tbx::Uid& shader)
+    void SDLShaderCache::Retire(ShaderMap::iterator shader)
     {
-        return _cachedShaders.find(shader)->second;
+        _residentBytes -= shader->second.Size;
+
+        // Keep the node alive until the last frame that used the shader has completed
+        RetiredShader retired = {};
+        retired.Frame = shader->second.LastUsedFrame;
+        retired.Node = _cachedShaders.extract(shader);
+        _retiredShaders.push_back(std::move(retired));
     }
 
     void SDLShaderCache::Clear()
     {
+        // Results of anything still compiling are ignored once they are no longer pending
+        _pendingShaders.clear();
+        _completedShaders.clear();
+        _failedShaders.clear();
+
+        if (_onEvicted)
+        {
+            for (const auto& [key, cachedShader] : _cachedShaders)
+            {
+                _onEvicted(key.Shader);
+            }
+        }
         _cachedShaders.clear();
+        _retiredShaders.clear();
+        _residentBytes = 0;
     }
 
-    std::vector<SDL_GPUVertexAttribute> SDLCreateVertexAttributes(const Tbx::BufferLayout& bufferLayout)
+    void SDLShaderCache::SetEvictionCallback(const std::function<void(const Tbx::Uid&)>& callback)
+    {
+        _onEvicted = callback;
+    }
+
+    void SDLShaderCache::SetDiskCacheDirectory(const std::string& directory)
+    {
+        _diskCache.SetDirectory(directory);
+    }
+
+    void SDLShaderCache::SetAsyncCompilation(Uint32 workerCount)
+    {
+        // Jobs still queued are dropped by the restart, forget them so the next Add queues or compiles them again.
+        // Results that already arrived stay pending until ProcessCompleted picks them up.
+        _compiler.Stop();
+        _compiler.TakeCompleted(_completedShaders);
+        _pendingShaders.clear();
+        for (const auto& result : _completedShaders)
+        {
+            _pendingShaders.insert({ result.Id, result.VariantId });
+        }
+
+        if (workerCount > 0)
+        {
+            _compiler.Start(workerCount, &_diskCache);
+        }
+    }
+
+    void SDLShaderCache::ProcessCompleted(SDL_GPUDevice* device)
+    {
+        _compiler.TakeCompleted(_completedShaders);
+        for (const auto& result : _completedShaders)
+        {
+            // Only pick up results the cache is still waiting for
+            const SDLShaderVariantKey key = { result.Id, result.VariantId };
+            if (_pendingShaders.erase(key) == 0)
+            {
+                continue;
+            }
+            if (!result.Succeeded)
+            {
+                RecordFailure(key);
+                continue;
+            }
+
+            Insert(key, result.Spirv, result.Type, device);
+        }
+        _completedShaders.clear();
+    }
+
+    Uint32 SDLShaderCache::GetPendingCount() const
+    {
+        return static_cast<Uint32>(_pendingShaders.size());
+    }
+
+    std::vector<SDL_GPUVertexAttribute> SDLCreateVertexAttributes(const Tbx::BufferLayout& bufferLayout, Uint32 instanceStride)
     {
         const std::vector<Tbx::BufferElement>& bufferElements = bufferLayout.GetElements();
         auto vertexAttributes = std::vector<SDL_GPUVertexAttribute>();
@@ -148,10 +357,23 @@ namespace SDLRendering
             offset += size;
         }
 
+        // Per instance data is exposed as consecutive float4 attributes on the instance buffer slot
+        const auto instanceLocation = static_cast<Uint32>(vertexAttributes.size());
+        for (Uint32 instanceOffset = 0; instanceOffset < instanceStride; instanceOffset += 16)
+        {
+            vertexAttributes.resize(vertexAttributes.size() + 1);
+            SDL_GPUVertexAttribute& vertexAttribute = vertexAttributes.back();
+
+            vertexAttribute.buffer_slot = 1;
+            vertexAttribute.location = instanceLocation + (instanceOffset / 16);
+            vertexAttribute.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4;
+            vertexAttribute.offset = instanceOffset;
+        }
+
         return vertexAttributes;
     }
 
-    std::vector<SDL_GPUVertexBufferDescription> SDLCreateVertexBufferDescriptions(const Tbx::BufferLayout& bufferLayout)
+    std::vector<SDL_GPUVertexBufferDescription> SDLCreateVertexBufferDescriptions(const Tbx::BufferLayout& bufferLayout, Uint32 instanceStride)
     {
         Uint32 stride = bufferLayout.GetStride();
 
@@ -164,6 +386,17 @@ namespace SDLRendering
         vertexBufferDesctiption.instance_step_rate = 0;
         vertexBufferDesctiption.pitch = stride;
 
+        if (instanceStride > 0)
+        {
+            vertexBufferDesctiptions.resize(vertexBufferDesctiptions.size() + 1);
+
+            SDL_GPUVertexBufferDescription& instanceBufferDesctiption = vertexBufferDesctiptions.back();
+            instanceBufferDesctiption.slot = 1;
+            instanceBufferDesctiption.input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE;
+            instanceBufferDesctiption.instance_step_rate = 0;
+            instanceBufferDesctiption.pitch = instanceStride;
+        }
+
         return vertexBufferDesctiptions;
     }
 
@@ -173,29 +406,9 @@ namespace SDLRendering
         return buffer;
     }
 
-    void SDLUploadBuffer(SDL_GPUBuffer* buffer, Uint32 sourceSize, const void* sourceData, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer)
+    void SDLUploadBuffer(SDL_GPUBuffer* buffer, Uint32 sourceSize, const void* sourceData, SDLUploadQueue& uploadQueue)
     {
-        SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {};
-        transferBufferCreateInfo.size = sourceSize;
-        transferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferBufferCreateInfo);
-
-        void* targetData = SDL_MapGPUTransferBuffer(device, transferBuffer, false);
-        SDL_memcpy(targetData, sourceData, sourceSize);
-        SDL_UnmapGPUTransferBuffer(device, transferBuffer);
-
-        SDL_GPUTransferBufferLocation transferBufferLocation = {};
-        transferBufferLocation.transfer_buffer = transferBuffer;
-        transferBufferLocation.offset = 0;
-
-        SDL_GPUBufferRegion bufferRegion = {};
-        bufferRegion.buffer = buffer;
-        bufferRegion.size = sourceSize;
-        bufferRegion.offset = 0;
-
-        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
-        SDL_UploadToGPUBuffer(copyPass, &transferBufferLocation, &bufferRegion, true);
-        SDL_EndGPUCopyPass(copyPass);
-        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        // The copy is recorded later together with the rest of the frame's uploads
+        uploadQueue.EnqueueBuffer(buffer, sourceSize, sourceData);
     }
 }
@@ -1,7 +1,12 @@
 #pragma once
+#include "SDLTransfer.h"
+#include "SDLShaderDiskCache.h"
+#include "SDLShaderCompiler.h"
+#include <unordered_set>
 #include <SDL3/SDL.h>
 #include <string>
 #include <unordered_map>
+#include <functional>
 #include <Tbx/Graphics/Buffers.h>
 #include <Tbx/Graphics/Material.h>
 
@@ -10,11 +15,30 @@ namespace SDLRendering
     struct SDLCachedShader
     {
         SDLCachedShader() = default;
-        SDLCachedShader(SDL_GPUShader* shader, SDL_GPUDevice* device);
+        SDLCachedShader(SDL_GPUShader* shader, const SDLShaderBindings& bindings, SDL_GPUDevice* device);
         ~SDLCachedShader();
 
         SDL_GPUShader* Shader = nullptr;
         SDL_GPUDevice* Device = nullptr;
+        SDLShaderBindings Bindings = {};
+
+        // Size of the SPIR-V the shader was created from, the closest measure of its driver memory we have
+        Uint64 Size = 0;
+        Uint64 LastUsedFrame = 0;
+    };
+
+    // Compiled shaders are identified by the shader and the define set they were specialized with
+    struct SDLShaderVariantKey
+    {
+        Tbx::Uid Shader;
+        Uint32 Variant = 0;
+
+        bool operator==(const SDLShaderVariantKey& other) const = default;
+    };
+
+    struct SDLShaderVariantKeyHasher
+    {
+        size_t operator()(const SDLShaderVariantKey& key) const;
     };
 
     struct SDLShaderCache
@@ -22,21 +46,94 @@ namespace SDLRendering
     public:
         ~SDLShaderCache();
 
-        void Add(const Tbx::Shader& shader, SDL_GPUDevice* device);
-        const SDLCachedShader& Get(const Tbx::Uid& shader);
+        // Compiles and caches the shader, when async compilation is on and allowed this only queues the work.
+        // A variant that failed to compile or create isn't cached, Add retries it after a back-off that doubles per failure.
+        void Add(const Tbx::Shader& shader, SDL_GPUDevice* device, bool allowAsync = true);
+        void Add(const Tbx::Shader& shader, const SDLShaderVariant& variant, SDL_GPUDevice* device, bool allowAsync = true);
+        // Returns an empty entry for variants that aren't cached, check IsReady first
+        const SDLCachedShader& Get(const Tbx::Uid& shader, Uint32 variant = 0);
+
+        // Returns true once the shader variant is compiled and can be used
+        bool IsReady(const Tbx::Uid& shader, Uint32 variant = 0) const;
+        bool IsPending(const Tbx::Uid& shader, Uint32 variant = 0) const;
 
+        // Removes every variant of the shader, the GPU shaders are released once the frames using them have completed.
+        // Compilations still running for it are dropped when they finish and past failures are forgotten.
+        void Remove(const Tbx::Uid& shader);
         void Clear();
 
+        // Advances the frame used for LRU tracking, releases shaders retired at or before completedFrame
+        // and evicts the least recently used variants until the cache fits its memory budget again
+        void BeginFrame(Uint64 frame, Uint64 completedFrame);
+
+        // Bytes of shader code the cache may hold, 0 is unlimited. Shaders used by the previous frame are never evicted.
+        void SetMemoryBudget(Uint64 bytes);
+        Uint64 GetResidentBytes() const { return _residentBytes; }
+        Uint64 GetEvictionCount() const { return _evictionCount; }
+
+        // GPU shaders created since the cache was made, evicted shaders that come back count again
+        Uint64 GetCreatedCount() const { return _createdCount; }
+
+        // Pinned shaders are never evicted, i.e. the fallback material's shaders
+        void SetPinned(const Tbx::Uid& shader, bool pinned);
+
+        // Called with the uid of every shader that leaves the cache so dependent objects (i.e. pipelines) can be dropped
+        void SetEvictionCallback(const std::function<void(const Tbx::Uid&)>& callback);
+
+        // Compiled SPIR-V is persisted here so later runs can skip HLSL compilation, an empty path disables it
+        void SetDiskCacheDirectory(const std::string& directory);
+
+        // Compiles shaders on the given number of worker threads instead of blocking in Add, 0 turns it off
+        void SetAsyncCompilation(Uint32 workerCount);
+
+        // Creates the GPU shaders for every background compilation that finished since the last call
+        void ProcessCompleted(SDL_GPUDevice* device);
+
+        Uint32 GetPendingCount() const;
+
     private:
-        std::unordered_map<Tbx::Uid, SDLCachedShader> _cachedShaders;
+        using ShaderMap = std::unordered_map<SDLShaderVariantKey, SDLCachedShader, SDLShaderVariantKeyHasher>;
+
+        // A shader that left the cache but may still be referenced by frames in flight
+        struct RetiredShader
+        {
+            Uint64 Frame = 0;
+            ShaderMap::node_type Node;
+        };
+
+        // A variant that failed, Add leaves it alone until RetryFrame
+        struct FailedShader
+        {
+            Uint64 RetryFrame = 0;
+            Uint32 Attempts = 0;
+        };
+
+        bool Insert(const SDLShaderVariantKey& key, const std::vector<Uint8>& spirv, Tbx::ShaderType type, SDL_GPUDevice* device);
+        void RecordFailure(const SDLShaderVariantKey& key);
+        void Retire(ShaderMap::iterator shader);
 
+        ShaderMap _cachedShaders;
+        std::vector<RetiredShader> _retiredShaders;
+        std::unordered_set<Tbx::Uid> _pinnedShaders;
+        std::function<void(const Tbx::Uid&)> _onEvicted = nullptr;
+        SDLShaderDiskCache _diskCache;
+        SDLShaderCompiler _compiler;
+        std::unordered_set<SDLShaderVariantKey, SDLShaderVariantKeyHasher> _pendingShaders;
+        std::vector<SDLShaderCompileResult> _completedShaders;
+        std::unordered_map<SDLShaderVariantKey, FailedShader, SDLShaderVariantKeyHasher> _failedShaders;
+        Uint64 _memoryBudget = 0;
+        Uint64 _residentBytes = 0;
+        Uint64 _evictionCount = 0;
+        Uint64 _createdCount = 0;
+        // Frames are counted from 1, shaders created before the first frame are first used by it
+        Uint64 _frameIndex = 1;
     };
 
-    std::vector<SDL_GPUVertexAttribute> SDLCreateVertexAttributes(const Tbx::BufferLayout& bufferLayout);
+    std::vector<SDL_GPUVertexAttribute> SDLCreateVertexAttributes(const Tbx::BufferLayout& bufferLayout, Uint32 instanceStride = 0);
 
-    std::vector<SDL_GPUVertexBufferDescription> SDLCreateVertexBufferDescriptions(const Tbx::BufferLayout& bufferLayout);
+    std::vector<SDL_GPUVertexBufferDescription> SDLCreateVertexBufferDescriptions(const Tbx::BufferLayout& bufferLayout, Uint32 instanceStride = 0);
 
     SDL_GPUBuffer* SDLCreateBuffer(const SDL_GPUBufferCreateInfo& bufferCreateInfo, SDL_GPUDevice* device);
 
-    void SDLUploadBuffer(SDL_GPUBuffer* buffer, Uint32 sourceSize, const void* sourceData, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer);
+    void SDLUploadBuffer(SDL_GPUBuffer* buffer, Uint32 sourceSize, const void* sourceData, SDLUploadQueue& uploadQueue);
 }
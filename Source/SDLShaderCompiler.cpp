@@ -0,0 +1,155 @@
+#include "SDLShaderCompiler.h"
+#include <Tbx/Debug/Debugging.h>
+#include <SDL3_shadercross/SDL_shadercross.h>
+#include <algorithm>
+
+namespace SDLRendering
+{
+#ifdef TBX_DEBUG
+    static constexpr bool ShaderDebug = true;
+#else
+    static constexpr bool ShaderDebug = false;
+#endif
+    static constexpr const char* ShaderEntryPoint = "main";
+
+    static SDL_ShaderCross_ShaderStage GetShaderStage(Tbx::ShaderType type)
+    {
+        return type == Tbx::ShaderType::Vertex
+            ? SDL_SHADERCROSS_SHADERSTAGE_VERTEX
+            : SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+    }
+
+    void SDLShaderCompiler::Start(Uint32 workerCount, SDLShaderDiskCache* diskCache)
+    {
+        _pool.Start(workerCount, [diskCache](SDLShaderCompileJob& job)
+        {
+            SDLShaderCompileResult result = {};
+            result.Id = job.Id;
+            result.VariantId = job.Variant.Id;
+            result.Type = job.Type;
+            result.Succeeded = SDLCompileSPIRV(job.Source, job.Type, job.Variant, diskCache, result.Spirv);
+            return result;
+        });
+    }
+
+    SDLShaderVariant SDLMakeShaderVariant(std::vector<std::string> defines)
+    {
+        std::sort(defines.begin(), defines.end());
+        defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+        SDLShaderVariant variant = {};
+        variant.Defines = std::move(defines);
+        variant.Hash = SDLHashShaderDefines(variant.Defines);
+        return variant;
+    }
+
+    SDLShaderVariant SDLShaderVariantTable::Intern(std::vector<std::string> defines)
+    {
+        SDLShaderVariant variant = SDLMakeShaderVariant(std::move(defines));
+        if (variant.Defines.empty())
+        {
+            return variant;
+        }
+
+        const auto [first, last] = _ids.equal_range(variant.Hash);
+        for (auto i = first; i != last; ++i)
+        {
+            if (_variants[i->second - 1].Defines == variant.Defines)
+            {
+                return _variants[i->second - 1];
+            }
+        }
+
+        // Ids start at 1, 0 is the empty set
+        variant.Id = static_cast<Uint32>(_variants.size()) + 1;
+        _variants.push_back(variant);
+        _ids.emplace(variant.Hash, variant.Id);
+        return variant;
+    }
+
+    bool SDLCompileSPIRV(const std::string& source, Tbx::ShaderType type, const SDLShaderVariant& variant, SDLShaderDiskCache* diskCache, std::vector<Uint8>& spirv)
+    {
+        const SDL_ShaderCross_ShaderStage stage = GetShaderStage(type);
+
+        // Reuse the SPIR-V from a previous run if the source didn't change, otherwise compile and persist it
+        const Uint64 sourceHash = SDLHashShaderSource(source, ShaderEntryPoint, (Uint32)stage, variant.Defines, ShaderDebug);
+        if (diskCache != nullptr && diskCache->Load(sourceHash, spirv))
+        {
+            return true;
+        }
+
+        // Split "NAME=VALUE" defines into the null terminated list shadercross expects
+        std::vector<std::string> defineNames = {};
+        std::vector<std::string> defineValues = {};
+        std::vector<SDL_ShaderCross_HLSL_Define> defines = {};
+        defineNames.reserve(variant.Defines.size());
+        defineValues.reserve(variant.Defines.size());
+        for (const auto& define : variant.Defines)
+        {
+            const size_t separator = define.find('=');
+            defineNames.push_back(define.substr(0, separator));
+            defineValues.push_back(separator != std::string::npos ? define.substr(separator + 1) : "1");
+        }
+        for (size_t i = 0; i < defineNames.size(); i++)
+        {
+            SDL_ShaderCross_HLSL_Define hlslDefine = {};
+            hlslDefine.name = defineNames[i].data();
+            hlslDefine.value = defineValues[i].data();
+            defines.push_back(hlslDefine);
+        }
+        defines.push_back({ nullptr, nullptr });
+
+        SDL_ShaderCross_HLSL_Info info = {};
+        info.source = source.c_str();
+        info.entrypoint = ShaderEntryPoint;
+        info.shader_stage = stage;
+        info.enable_debug = ShaderDebug;
+        info.include_dir = nullptr;
+        info.defines = defines.data();
+        info.name = nullptr;
+
+        size_t size = 0;
+        void* data = SDL_ShaderCross_CompileSPIRVFromHLSL(&info, &size);
+        if (data == nullptr || size == 0)
+        {
+            TBX_TRACE_ERROR("Failed to compile shader: {}", SDL_GetError());
+            return false;
+        }
+
+        spirv.assign((Uint8*)data, (Uint8*)data + size);
+        if (diskCache != nullptr)
+        {
+            diskCache->Store(sourceHash, data, size);
+        }
+        SDL_free(data);
+        return true;
+    }
+
+    SDL_GPUShader* SDLCreateShaderFromSPIRV(const std::vector<Uint8>& spirv, Tbx::ShaderType type, SDL_GPUDevice* device, SDLShaderBindings& bindings)
+    {
+        SDL_ShaderCross_SPIRV_Info vertexInfo = {};
+        vertexInfo.entrypoint = ShaderEntryPoint;
+        vertexInfo.bytecode = spirv.data();
+        vertexInfo.bytecode_size = spirv.size();
+        vertexInfo.shader_stage = GetShaderStage(type);
+        vertexInfo.enable_debug = ShaderDebug;
+
+        // Let the shader tell us what it binds instead of guessing
+        SDL_ShaderCross_GraphicsShaderMetadata* shaderMetadata = SDL_ShaderCross_ReflectGraphicsSPIRV(spirv.data(), spirv.size(), 0);
+        if (shaderMetadata == nullptr)
+        {
+            TBX_ASSERT(false, "Failed to reflect shader: {}", SDL_GetError());
+            return nullptr;
+        }
+
+        bindings.NumSamplers = shaderMetadata->num_samplers;
+        bindings.NumUniformBuffers = shaderMetadata->num_uniform_buffers;
+        bindings.NumStorageTextures = shaderMetadata->num_storage_textures;
+        bindings.NumStorageBuffers = shaderMetadata->num_storage_buffers;
+
+        SDL_GPUShader* compiledShader = SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(device, &vertexInfo, shaderMetadata, 0);
+        TBX_ASSERT(compiledShader != nullptr, "Failed to compile shader: {}", SDL_GetError());
+        SDL_free(shaderMetadata);
+        return compiledShader;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "SDLShaderDiskCache.h"
+#include "SDLWorkerPool.h"
+#include <SDL3/SDL.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Tbx/Graphics/Material.h>
+
+namespace SDLRendering
+{
+    // Resources a compiled shader actually declares, as reported by SPIR-V reflection
+    struct SDLShaderBindings
+    {
+        Uint32 NumSamplers = 0;
+        Uint32 NumUniformBuffers = 0;
+        Uint32 NumStorageTextures = 0;
+        Uint32 NumStorageBuffers = 0;
+    };
+
+    // A set of preprocessor defines ("NAME" or "NAME=VALUE") a shader is specialized with.
+    // The defines are kept sorted so the same set always hashes the same. Caches key variants by Id,
+    // which SDLShaderVariantTable only hands out after comparing the define lists. The empty set is always Id 0.
+    struct SDLShaderVariant
+    {
+        std::vector<std::string> Defines = {};
+        Uint64 Hash = 0;
+        Uint32 Id = 0;
+    };
+
+    // Interns define sets, the same set always gets the same id and different sets never share one
+    struct SDLShaderVariantTable
+    {
+    public:
+        SDLShaderVariant Intern(std::vector<std::string> defines);
+
+    private:
+        std::vector<SDLShaderVariant> _variants = {};
+        std::unordered_multimap<Uint64, Uint32> _ids = {};
+    };
+
+    struct SDLShaderCompileJob
+    {
+        Tbx::Uid Id;
+        Tbx::ShaderType Type = Tbx::ShaderType::Vertex;
+        std::string Source = "";
+        SDLShaderVariant Variant = {};
+    };
+
+    struct SDLShaderCompileResult
+    {
+        Tbx::Uid Id;
+        Uint32 VariantId = 0;
+        Tbx::ShaderType Type = Tbx::ShaderType::Vertex;
+        std::vector<Uint8> Spirv = {};
+        bool Succeeded = false;
+    };
+
+    // Compiles HLSL to SPIR-V on a worker pool in the background.
+    // Only the CPU heavy compilation runs on the workers, the finished SPIR-V is turned into
+    // GPU shaders on the render thread when the results are collected.
+    struct SDLShaderCompiler
+    {
+    public:
+        void Start(Uint32 workerCount, SDLShaderDiskCache* diskCache);
+        void Stop() { _pool.Stop(); }
+        bool IsRunning() const { return _pool.IsRunning(); }
+
+        void Enqueue(SDLShaderCompileJob job) { _pool.Enqueue(std::move(job)); }
+
+        // Moves every finished result into the given list
+        void TakeCompleted(std::vector<SDLShaderCompileResult>& results) { _pool.TakeCompleted(results); }
+
+        // Jobs that are queued or being compiled right now
+        Uint32 GetPendingCount() const { return _pool.GetPendingCount(); }
+
+    private:
+        SDLWorkerPool<SDLShaderCompileJob, SDLShaderCompileResult> _pool;
+    };
+
+    // Sorts and hashes the defines, the variant has no Id until it is interned
+    SDLShaderVariant SDLMakeShaderVariant(std::vector<std::string> defines);
+
+    // Compiles HLSL with the variant's defines to SPIR-V, going through the disk cache first if one is given
+    bool SDLCompileSPIRV(const std::string& source, Tbx::ShaderType type, const SDLShaderVariant& variant, SDLShaderDiskCache* diskCache, std::vector<Uint8>& spirv);
+
+    // Reflects the SPIR-V to fill in the shader's resource counts and creates the GPU shader from it
+    SDL_GPUShader* SDLCreateShaderFromSPIRV(const std::vector<Uint8>& spirv, Tbx::ShaderType type, SDL_GPUDevice* device, SDLShaderBindings& bindings);
+}
@@ -0,0 +1,60 @@
+#include "SDLShaderDiskCache.h"
+#include <SDL3_shadercross/SDL_shadercross.h>
+
+namespace SDLRendering
+{
+    static constexpr Uint32 ShaderCacheMagic = 0x53584254; // "TBXS"
+
+    SDLShaderDiskCache::SDLShaderDiskCache()
+        : _cache("shader", ".spv", ShaderCacheMagic, SDLGetShaderCrossVersion())
+    {
+    }
+
+    void SDLShaderDiskCache::SetDirectory(const std::string& directory)
+    {
+        _cache.SetDirectory(directory);
+    }
+
+    bool SDLShaderDiskCache::Load(Uint64 key, std::vector<Uint8>& bytecode)
+    {
+        return _cache.Load(key, bytecode);
+    }
+
+    void SDLShaderDiskCache::Store(Uint64 key, const void* bytecode, size_t size)
+    {
+        _cache.Store(key, bytecode, size);
+    }
+
+    Uint64 SDLHashShaderSource(const std::string& source, const char* entryPoint, Uint32 stage, const std::vector<std::string>& defines, bool debug)
+    {
+        const Uint32 shaderCrossVersion = SDLGetShaderCrossVersion();
+        const Uint8 debugFlag = debug ? 1 : 0;
+
+        Uint64 hash = SDLHashBytes(source.data(), source.size());
+        hash = SDLHashBytes(entryPoint, SDL_strlen(entryPoint), hash);
+        hash = SDLHashBytes(&stage, sizeof(stage), hash);
+        hash = SDLHashShaderDefines(defines, hash);
+        hash = SDLHashBytes(&debugFlag, sizeof(debugFlag), hash);
+        hash = SDLHashBytes(&shaderCrossVersion, sizeof(shaderCrossVersion), hash);
+        return hash;
+    }
+
+    Uint64 SDLHashShaderDefines(const std::vector<std::string>& defines, Uint64 hash)
+    {
+        for (const auto& define : defines)
+        {
+            // Include the terminator so {"AB"} and {"A", "B"} don't collide
+            hash = SDLHashBytes(define.c_str(), define.size() + 1, hash);
+        }
+        return hash;
+    }
+
+    Uint32 SDLGetShaderCrossVersion()
+    {
+#ifdef SDL_SHADERCROSS_MAJOR_VERSION
+        return SDL_SHADERCROSS_MAJOR_VERSION * 1000000 + SDL_SHADERCROSS_MINOR_VERSION * 1000 + SDL_SHADERCROSS_MICRO_VERSION;
+#else
+        return 0;
+#endif
+    }
+}
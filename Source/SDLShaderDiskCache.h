@@ -0,0 +1,32 @@
+#pragma once
+#include "SDLDiskCache.h"
+#include "SDLHash.h"
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+
+namespace SDLRendering
+{
+    // Persists compiled shader bytecode between runs, entries written by another shadercross version are misses
+    struct SDLShaderDiskCache
+    {
+    public:
+        SDLShaderDiskCache();
+
+        void SetDirectory(const std::string& directory);
+        const std::string& GetDirectory() const { return _cache.GetDirectory(); }
+
+        bool Load(Uint64 key, std::vector<Uint8>& bytecode);
+        void Store(Uint64 key, const void* bytecode, size_t size);
+
+    private:
+        SDLDiskCache _cache;
+    };
+
+    // Hashes everything that influences the compiled bytecode of a shader
+    Uint64 SDLHashShaderSource(const std::string& source, const char* entryPoint, Uint32 stage, const std::vector<std::string>& defines, bool debug);
+
+    Uint64 SDLHashShaderDefines(const std::vector<std::string>& defines, Uint64 hash = SDLHashSeed);
+
+    Uint32 SDLGetShaderCrossVersion();
+}
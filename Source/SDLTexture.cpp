@@ -1,174 +1,748 @@
 #include "SDLTexture.h"
 #include "SDLRenderer.h"
+#include "SDLPixelConversion.h"
 #include <Tbx/Debug/Debugging.h>
 #include <SDL3_shadercross/SDL_shadercross.h>
+#include <algorithm>
 
 namespace SDLRendering
 {
-    SDLCachedTexture::SDLCachedTexture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler, SDL_GPUDevice* device)
+    SDLTextureArray::SDLTextureArray(SDL_GPUTexture* texture, Uint32 width, Uint32 height, Uint32 levelCount, Uint32 layerCount, SDL_GPUDevice* device)
+    {
+        Texture = texture;
+        Device = device;
+        Width = width;
+        Height = height;
+        LevelCount = levelCount;
+        LayerCount = layerCount;
+
+        // Hand out the lowest layers first
+        for (Uint32 layer = layerCount; layer > 0; layer--)
+        {
+            FreeLayers.push_back(layer - 1);
+        }
+    }
+
+    SDLTextureArray::~SDLTextureArray()
+    {
+        if (Texture != nullptr)
+        {
+            SDL_ReleaseGPUTexture(Device, Texture);
+            Texture = nullptr;
+        }
+    }
+
+    bool SDLTextureArray::AllocateLayer(Uint32& layer)
+    {
+        if (FreeLayers.empty())
+        {
+            return false;
+        }
+
+        layer = FreeLayers.back();
+        FreeLayers.pop_back();
+        return true;
+    }
+
+    void SDLTextureArray::FreeLayer(Uint32 layer)
+    {
+        FreeLayers.push_back(layer);
+    }
+
+    SDLCachedTexture::SDLCachedTexture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler, SDLSamplerCache* samplerCache, SDL_GPUDevice* device)
     {
         Texture = texture;
         Sampler = sampler;
+        SamplerCache = samplerCache;
         Device = device;
     }
 
     SDLCachedTexture::~SDLCachedTexture()
     {
-        if (Texture != nullptr)
+        if (Array != nullptr)
+        {
+            // The array is shared, only give the layer back
+            Array->FreeLayer(Layer);
+            Array = nullptr;
+            Texture = nullptr;
+        }
+        else if (Texture != nullptr)
         {
             SDL_ReleaseGPUTexture(Device, Texture);
             Texture = nullptr;
         }
 
-        if (Sampler != nullptr)
+        if (Sampler != nullptr && SamplerCache != nullptr)
         {
-            SDL_ReleaseGPUSampler(Device, Sampler);
+            SamplerCache->Release(Sampler);
             Sampler = nullptr;
         }
     }
 
+    static Uint64 GetRGBATextureSize(Uint32 width, Uint32 height, SDLMipmapMode mipmaps)
+    {
+        const Uint32 levelCount = mipmaps != SDLMipmapMode::None ? SDLGetMipLevelCount(width, height) : 1;
+        Uint64 size = 0;
+        for (Uint32 level = 0; level < levelCount; level++)
+        {
+            size += static_cast<Uint64>(SDL_max(width >> level, 1u)) * SDL_max(height >> level, 1u) * 4;
+        }
+        return size;
+    }
+
     SDLTextureCache::~SDLTextureCache()
     {
+        _streamer.Stop();
         Clear();
     }
 
-    void SDLTextureCache::Add(const Tbx::Texture& texture, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer)
+    void SDLTextureCache::Initialize(SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
     {
+        // A single opaque white texel, so untextured lighting still looks right while the real texture streams in
+        const Uint8 placeholderPixel[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+        SDL_GPUSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.min_filter = SDL_GPU_FILTER_NEAREST;
+        samplerCreateInfo.mag_filter = SDL_GPU_FILTER_NEAREST;
+        samplerCreateInfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+        samplerCreateInfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        samplerCreateInfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        samplerCreateInfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+
+        _placeholder.reset();
+        _placeholder.emplace(
+            SDLCreateTexture(1, 1, placeholderPixel, SDLMipmapMode::None, device, uploadQueue),
+            _samplerCache.Acquire(samplerCreateInfo, device),
+            &_samplerCache,
+            device);
+
+        // The same texel in a single layer array, bound in place of packed textures
+        SDL_GPUTexture* arrayPlaceholder = SDLCreateTextureArray(1, 1, 1, 1, device);
+        if (arrayPlaceholder != nullptr)
+        {
+            uploadQueue.EnqueueTexture(arrayPlaceholder, sizeof(placeholderPixel), placeholderPixel, 1, 1, 0, 0);
+        }
+        _arrayPlaceholder.reset();
+        _arrayPlaceholder.emplace(
+            arrayPlaceholder,
+            _samplerCache.Acquire(samplerCreateInfo, device),
+            &_samplerCache,
+            device);
+    }
+
+    void SDLTextureCache::Add(const Tbx::Texture& texture, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
+    {
+        // Staged by this frame, so it counts as used even if no draw ends up binding it
         const auto i = _cachedTextures.find(texture.GetId());
-        if (i == _cachedTextures.end())
+        if (i != _cachedTextures.end())
+        {
+            i->second.LastUsedFrame = _frameIndex;
+            return;
+        }
+        if (_streamingTextures.contains(texture.GetId()))
         {
-            Tbx::TextureFilter textureFilter = texture.GetFilter();
-            Tbx::TextureWrap textureWrap = texture.GetWrap();
+            return;
+        }
 
-            auto* surface = SDLMakeSurface(texture);
-            if (surface != nullptr)
+        // Hand the conversion to the workers, the texture is uploaded once ProcessStreaming gets to it
+        if (_streamer.IsRunning())
+        {
+            // Packed textures need their whole mip chain up front to upload it into their layer
+            SDLTextureStreamJob job = {};
+            job.Texture = texture;
+            job.Mipmaps = GetMipmapMode(texture.GetId());
+            job.CompressedFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+            if (_packedTextures.contains(texture.GetId()))
             {
-                _cachedTextures.emplace(
-                    std::piecewise_construct,
-                    std::forward_as_tuple(texture.GetId()),
-                    std::forward_as_tuple(SDLCreateTexture(surface, device, commandBuffer), SDLMakeSampler(texture, device), device));
-                SDL_DestroySurface(surface);
+                job.Mipmaps = job.Mipmaps != SDLMipmapMode::None ? SDLMipmapMode::Cpu : SDLMipmapMode::None;
             }
             else
             {
-                TBX_ASSERT(false, "Failed to create SDL_Surface: {}", SDL_GetError());
+                job.CompressedFormat = SDLSelectCompressedFormat(texture, GetCompression(texture.GetId()), device);
+            }
+            _streamer.Enqueue(std::move(job));
+            _streamingTextures.insert(texture.GetId());
+            return;
+        }
+
+        if (_packedTextures.contains(texture.GetId()))
+        {
+            const SDLMipmapMode packedMipmaps = GetMipmapMode(texture.GetId()) != SDLMipmapMode::None ? SDLMipmapMode::Cpu : SDLMipmapMode::None;
+            const auto width = static_cast<Uint32>(texture.GetWidth());
+            const auto height = static_cast<Uint32>(texture.GetHeight());
+
+            std::vector<Uint8> pixels = {};
+            if (!SDLConvertTexturePixels(texture, pixels))
+            {
                 return;
             }
+            if (packedMipmaps == SDLMipmapMode::Cpu)
+            {
+                SDLGenerateMipChain(pixels, width, height);
+            }
+
+            // Its shader samples an array, so a plain texture is no fallback
+            if (!AddPacked(texture, width, height, pixels, packedMipmaps, device, uploadQueue))
+            {
+                TBX_TRACE_WARN("A {}x{} texture could not be packed, the array placeholder is bound in its place", width, height);
+            }
+            return;
+        }
+
+        // Upload pre-compressed blocks when the texture should be compressed, plain RGBA if encoding isn't possible
+        SDL_GPUTexture* gpuTexture = nullptr;
+        Uint64 gpuTextureSize = 0;
+        const SDLMipmapMode mipmaps = GetMipmapMode(texture.GetId());
+        const SDL_GPUTextureFormat compressedFormat = SDLSelectCompressedFormat(texture, GetCompression(texture.GetId()), device);
+        SDLCompressedTexture compressed = {};
+        if (compressedFormat != SDL_GPU_TEXTUREFORMAT_INVALID && SDLLoadOrCompressTexture(texture, compressedFormat, mipmaps, &_diskCache, compressed))
+        {
+            gpuTexture = SDLCreateTexture(compressed, device, uploadQueue);
+            gpuTextureSize = compressed.Blocks.size();
+        }
+        else
+        {
+            gpuTexture = SDLCreateTexture(texture, mipmaps, device, uploadQueue);
+            gpuTextureSize = GetRGBATextureSize(static_cast<Uint32>(texture.GetWidth()), static_cast<Uint32>(texture.GetHeight()), mipmaps);
         }
+
+        if (gpuTexture == nullptr)
+        {
+            TBX_ASSERT(false, "Failed to create texture: {}", SDL_GetError());
+            return;
+        }
+
+        Insert(texture, gpuTexture, gpuTextureSize, device);
     }
 
     const SDLCachedTexture& SDLTextureCache::Get(const Tbx::Uid& texture)
     {
-        return _cachedTextures.find(texture)->second;
+        static const SDLCachedTexture missingTexture = {};
+
+        const auto i = _cachedTextures.find(texture);
+        if (i != _cachedTextures.end())
+        {
+            i->second.LastUsedFrame = _frameIndex;
+            return i->second;
+        }
+
+        const auto& placeholder = _packedTextures.contains(texture) ? _arrayPlaceholder : _placeholder;
+        return placeholder.has_value() ? placeholder.value() : missingTexture;
+    }
+
+    void SDLTextureCache::Remove(const Tbx::Uid& texture)
+    {
+        // A result still being converted is dropped when it comes in
+        _streamingTextures.erase(texture);
+
+        const auto i = _cachedTextures.find(texture);
+        if (i != _cachedTextures.end())
+        {
+            Retire(i);
+        }
     }
 
-    void SDLTextureCache::Clear()
+    void SDLTextureCache::BeginFrame(Uint64 frame, Uint64 completedFrame)
     {
-        _cachedTextures.clear();
+        _frameIndex = frame;
+
+        std::erase_if(_retiredTextures, [completedFrame](const RetiredTexture& retired)
+        {
+            return retired.Frame <= completedFrame;
+        });
+
+        // Arrays whose layers have all been released go with them
+        std::erase_if(_textureArrays, [](const std::unique_ptr<SDLTextureArray>& array)
+        {
+            return array->IsEmpty();
+        });
+
+        if (_memoryBudget == 0 || _residentBytes <= _memoryBudget)
+        {
+            return;
+        }
+
+        // Least recently used first, anything the previous frame drew stays
+        std::vector<std::pair<Uint64, Tbx::Uid>> candidates = {};
+        for (const auto& [id, cachedTexture] : _cachedTextures)
+        {
+            if (cachedTexture.LastUsedFrame + 1 < frame && !_pinnedTextures.contains(id))
+            {
+                candidates.emplace_back(cachedTexture.LastUsedFrame, id);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (const auto& [lastUsedFrame, id] : candidates)
+        {
+            if (_residentBytes <= _memoryBudget)
+            {
+                break;
+            }
+            Retire(_cachedTextures.find(id));
+            _evictionCount++;
+        }
     }
 
-    SDL_GPUTexture* SDLCreateTexture(const SDL_Surface* surface, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer)
+    void SDLTextureCache::SetMemoryBudget(Uint64 bytes)
     {
-        const Uint32 textureWidth = static_cast<Uint32>(surface->w);
-        const Uint32 textureHeight = static_cast<Uint32>(surface->h);
+        _memoryBudget = bytes;
+    }
 
-        // After normalization we only expect RGBA32 here
-        if (surface->format != SDL_PIXELFORMAT_RGBA32)
+    void SDLTextureCache::SetPinned(const Tbx::Uid& texture, bool pinned)
+    {
+        if (pinned)
         {
-            TBX_ASSERT(false, "Unexpected surface format; expected RGBA32 after conversion.");
-            return nullptr;
+            _pinnedTextures.insert(texture);
         }
+        else
+        {
+            _pinnedTextures.erase(texture);
+        }
+    }
+
+    void SDLTextureCache::Insert(const Tbx::Texture& texture, SDL_GPUTexture* gpuTexture, Uint64 size, SDL_GPUDevice* device, SDLTextureArray* array, Uint32 layer)
+    {
+        auto [i, inserted] = _cachedTextures.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(texture.GetId()),
+            std::forward_as_tuple(gpuTexture, _samplerCache.Acquire(SDLMakeSamplerInfo(texture), device), &_samplerCache, device));
+
+        // The upload is recorded by the current frame, which counts as a use
+        i->second.Array = array;
+        i->second.Layer = layer;
+        i->second.Size = size;
+        i->second.LastUsedFrame = _frameIndex;
+        _residentBytes += size;
+    }
 
-        // Setup creation info
+    void SDLTextureCache::Retire(TextureMap::iterator texture)
+    {
+        _residentBytes -= texture->second.Size;
+
+        // Keep the node alive until the last frame that used the texture has completed
+        RetiredTexture retired = {};
+        retired.Frame = texture->second.LastUsedFrame;
+        retired.Node = _cachedTextures.extract(texture);
+        _retiredTextures.push_back(std::move(retired));
+    }
+
+    bool SDLTextureCache::IsPackable(const Tbx::Texture& texture) const
+    {
+        return static_cast<Uint32>(texture.GetWidth()) <= _maxPackedSize &&
+            static_cast<Uint32>(texture.GetHeight()) <= _maxPackedSize;
+    }
+
+    bool SDLTextureCache::AddPacked(const Tbx::Texture& texture, Uint32 width, Uint32 height, const std::vector<Uint8>& pixels, SDLMipmapMode mipmaps, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
+    {
+        const Uint32 levelCount = mipmaps != SDLMipmapMode::None ? SDLGetMipLevelCount(width, height) : 1;
+
+        // Textures over the size limit still have to be arrays, they just don't share theirs
+        const Uint32 layerCount = IsPackable(texture) ? _arrayLayerCount : 1;
+
+        // Take a layer of the first matching array that has one free, a new array is only made once they are all full
+        SDLTextureArray* array = nullptr;
+        Uint32 layer = 0;
+        for (const auto& candidate : _textureArrays)
+        {
+            if (candidate->Width == width && candidate->Height == height && candidate->LevelCount == levelCount && candidate->AllocateLayer(layer))
+            {
+                array = candidate.get();
+                break;
+            }
+        }
+
+        if (array == nullptr)
+        {
+            SDL_GPUTexture* arrayTexture = SDLCreateTextureArray(width, height, levelCount, layerCount, device);
+            if (arrayTexture == nullptr)
+            {
+                TBX_TRACE_WARN("Failed to create texture array: {}", SDL_GetError());
+                return false;
+            }
+
+            array = _textureArrays.emplace_back(std::make_unique<SDLTextureArray>(arrayTexture, width, height, levelCount, layerCount, device)).get();
+            array->AllocateLayer(layer);
+        }
+
+        const Uint8* levelPixels = pixels.data();
+        for (Uint32 level = 0; level < levelCount; level++)
+        {
+            const Uint32 levelWidth = SDL_max(width >> level, 1u);
+            const Uint32 levelHeight = SDL_max(height >> level, 1u);
+            const Uint32 levelSize = levelWidth * levelHeight * 4;
+            uploadQueue.EnqueueTexture(array->Texture, levelSize, levelPixels, levelWidth, levelHeight, level, layer);
+            levelPixels += levelSize;
+        }
+
+        Insert(texture, array->Texture, GetRGBATextureSize(width, height, mipmaps), device, array, layer);
+        return true;
+    }
+
+    SDLTextureResidency SDLTextureCache::GetResidency(const Tbx::Uid& texture) const
+    {
+        if (_cachedTextures.contains(texture))
+        {
+            return SDLTextureResidency::Resident;
+        }
+        if (_streamingTextures.contains(texture))
+        {
+            return SDLTextureResidency::Streaming;
+        }
+        return SDLTextureResidency::Missing;
+    }
+
+    void SDLTextureCache::SetStreaming(Uint32 workerCount, Uint32 bytesPerFrame)
+    {
+        _streamingBudget = bytesPerFrame;
+
+        // Jobs still queued are dropped by the restart, forget them so the next Add queues them again
+        _streamer.Stop();
+        _streamer.TakeCompleted(_streamedTextures);
+        _streamingTextures.clear();
+        for (const auto& result : _streamedTextures)
+        {
+            _streamingTextures.insert(result.Texture.GetId());
+        }
+
+        if (workerCount > 0)
+        {
+            _streamer.Start(workerCount, &_diskCache);
+        }
+    }
+
+    void SDLTextureCache::ProcessStreaming(SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
+    {
+        _streamer.TakeCompleted(_streamedTextures);
+
+        Uint32 uploadedBytes = 0;
+        while (!_streamedTextures.empty())
+        {
+            const auto& result = _streamedTextures.front();
+            const auto textureId = result.Texture.GetId();
+            const auto textureSize = static_cast<Uint32>(result.Pixels.size() + result.Compressed.Blocks.size());
+
+            // Only pick up results the cache is still waiting for
+            if (!_streamingTextures.contains(textureId) || !result.Succeeded)
+            {
+                _streamingTextures.erase(textureId);
+                _streamedTextures.pop_front();
+                continue;
+            }
+
+            // Always let the first texture through so ones bigger than the budget still get uploaded
+            if (_streamingBudget > 0 && uploadedBytes > 0 && uploadedBytes + textureSize > _streamingBudget)
+            {
+                break;
+            }
+
+            // The workers already built the chain a packed texture needs. A result compressed before packing was turned on
+            // is dropped, so the next Add queues the texture again.
+            if (_packedTextures.contains(textureId))
+            {
+                if (result.Compressed.Format == SDL_GPU_TEXTUREFORMAT_INVALID &&
+                    !AddPacked(result.Texture, result.Width, result.Height, result.Pixels, result.Mipmaps, device, uploadQueue))
+                {
+                    TBX_TRACE_WARN("A {}x{} texture could not be packed, the array placeholder is bound in its place", result.Width, result.Height);
+                }
+                uploadedBytes += textureSize;
+                _streamingTextures.erase(textureId);
+                _streamedTextures.pop_front();
+                continue;
+            }
+
+            auto* gpuTexture = result.Compressed.Format != SDL_GPU_TEXTUREFORMAT_INVALID
+                ? SDLCreateTexture(result.Compressed, device, uploadQueue)
+                : SDLCreateTexture(result.Width, result.Height, result.Pixels.data(), result.Mipmaps, device, uploadQueue);
+            if (gpuTexture != nullptr)
+            {
+                const Uint64 gpuTextureSize = result.Compressed.Format != SDL_GPU_TEXTUREFORMAT_INVALID
+                    ? result.Compressed.Blocks.size()
+                    : GetRGBATextureSize(result.Width, result.Height, result.Mipmaps);
+                Insert(result.Texture, gpuTexture, gpuTextureSize, device);
+            }
+            else
+            {
+                TBX_TRACE_ERROR("Failed to create texture: {}", SDL_GetError());
+            }
+
+            uploadedBytes += textureSize;
+            _streamingTextures.erase(textureId);
+            _streamedTextures.pop_front();
+        }
+    }
+
+    Uint32 SDLTextureCache::GetStreamingCount() const
+    {
+        return static_cast<Uint32>(_streamingTextures.size());
+    }
+
+    void SDLTextureCache::SetDefaultMipmapMode(SDLMipmapMode mode)
+    {
+        _defaultMipmapMode = mode;
+    }
+
+    void SDLTextureCache::SetMipmapMode(const Tbx::Uid& texture, SDLMipmapMode mode)
+    {
+        _mipmapModes[texture] = mode;
+    }
+
+    SDLMipmapMode SDLTextureCache::GetMipmapMode(const Tbx::Uid& texture) const
+    {
+        const auto i = _mipmapModes.find(texture);
+        return i != _mipmapModes.end() ? i->second : _defaultMipmapMode;
+    }
+
+    void SDLTextureCache::SetDefaultCompression(SDLTextureCompression compression)
+    {
+        _defaultCompression = compression;
+    }
+
+    void SDLTextureCache::SetCompression(const Tbx::Uid& texture, SDLTextureCompression compression)
+    {
+        _compressionModes[texture] = compression;
+    }
+
+    SDLTextureCompression SDLTextureCache::GetCompression(const Tbx::Uid& texture) const
+    {
+        const auto i = _compressionModes.find(texture);
+        return i != _compressionModes.end() ? i->second : _defaultCompression;
+    }
+
+    void SDLTextureCache::SetDiskCacheDirectory(const std::string& directory)
+    {
+        _diskCache.SetDirectory(directory);
+    }
+
+    void SDLTextureCache::SetArrayPacking(const Tbx::Uid& texture, bool packed)
+    {
+        if (packed)
+        {
+            _packedTextures.insert(texture);
+        }
+        else
+        {
+            _packedTextures.erase(texture);
+        }
+    }
+
+    bool SDLTextureCache::GetArrayPacking(const Tbx::Uid& texture) const
+    {
+        return _packedTextures.contains(texture);
+    }
+
+    bool SDLTextureCache::IsPacked(const Tbx::Uid& texture) const
+    {
+        const auto i = _cachedTextures.find(texture);
+        return i != _cachedTextures.end() && i->second.Array != nullptr;
+    }
+
+    void SDLTextureCache::SetArrayPackingLimits(Uint32 maxSize, Uint32 layerCount)
+    {
+        _maxPackedSize = maxSize;
+        _arrayLayerCount = SDL_max(layerCount, 1u);
+    }
+
+    void SDLTextureCache::Clear()
+    {
+        // Results of anything still converting are ignored once they are no longer streaming
+        _streamingTextures.clear();
+        _streamedTextures.clear();
+
+        _cachedTextures.clear();
+        _retiredTextures.clear();
+        _textureArrays.clear();
+        _placeholder.reset();
+        _arrayPlaceholder.reset();
+        _samplerCache.Clear();
+        _residentBytes = 0;
+    }
+
+    static SDL_GPUTexture* CreateRGBATexture(Uint32 width, Uint32 height, SDLMipmapMode mipmaps, SDL_GPUDevice* device)
+    {
         SDL_GPUTextureCreateInfo info = {};
         info.type = SDL_GPU_TEXTURETYPE_2D;
         info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-        info.width = textureWidth;
-        info.height = textureHeight;
+        info.width = width;
+        info.height = height;
         info.layer_count_or_depth = 1;
-        info.num_levels = 1;
+        info.num_levels = mipmaps != SDLMipmapMode::None ? SDLGetMipLevelCount(width, height) : 1;
         info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
 
-        // Create and upload
-        auto* texture = SDL_CreateGPUTexture(device, &info);
-        SDLUploadTexture(texture, surface->pitch * surface->h, surface->pixels, surface->w, surface->h, device, commandBuffer);
-        return texture;
+        // The GPU generates mips by blitting into each level, which needs them to be render targets
+        if (mipmaps == SDLMipmapMode::Gpu && info.num_levels > 1)
+        {
+            info.usage |= SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+        }
+        return SDL_CreateGPUTexture(device, &info);
     }
 
-    void SDLUploadTexture(SDL_GPUTexture* texture, Uint32 textureSize, const void* textureData, Uint32 textureWidth, Uint32 textureHeight, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer)
+    SDL_GPUTexture* SDLCreateTextureArray(Uint32 width, Uint32 height, Uint32 levelCount, Uint32 layerCount, SDL_GPUDevice* device)
     {
-        SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {};
-        transferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        transferBufferCreateInfo.size = textureSize;
-        SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferBufferCreateInfo);
+        SDL_GPUTextureCreateInfo info = {};
+        info.type = SDL_GPU_TEXTURETYPE_2D_ARRAY;
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.width = width;
+        info.height = height;
+        info.layer_count_or_depth = layerCount;
+        info.num_levels = levelCount;
+        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        return SDL_CreateGPUTexture(device, &info);
+    }
 
-        void* targetData = SDL_MapGPUTransferBuffer(device, transferBuffer, false);
-        SDL_memcpy(targetData, textureData, textureSize);
-        SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    static void UploadMipChain(SDL_GPUTexture* texture, Uint32 width, Uint32 height, const Uint8* pixels, SDLUploadQueue& uploadQueue)
+    {
+        const Uint32 levelCount = SDLGetMipLevelCount(width, height);
+        for (Uint32 level = 0; level < levelCount; level++)
+        {
+            const Uint32 levelWidth = SDL_max(width >> level, 1u);
+            const Uint32 levelHeight = SDL_max(height >> level, 1u);
+            const Uint32 levelSize = levelWidth * levelHeight * 4;
+            uploadQueue.EnqueueTexture(texture, levelSize, pixels, levelWidth, levelHeight, level);
+            pixels += levelSize;
+        }
+    }
 
-        SDL_GPUTextureTransferInfo textureTransferInfo = {};
-        textureTransferInfo.transfer_buffer = transferBuffer;
-        textureTransferInfo.offset = 0;
+    SDL_GPUTexture* SDLCreateTexture(const Tbx::Texture& texture, SDLMipmapMode mipmaps, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
+    {
+        // Everything is uploaded as RGBA32
+        const auto width = static_cast<Uint32>(texture.GetWidth());
+        const auto height = static_cast<Uint32>(texture.GetHeight());
 
-        SDL_GPUTextureRegion textureRegion = {};
-        textureRegion.texture = texture;
-        textureRegion.w = textureWidth;
-        textureRegion.h = textureHeight;
-        textureRegion.d = 1;
+        // The CPU chain needs the converted base level to filter from, so it can't be written straight into transfer memory
+        if (mipmaps == SDLMipmapMode::Cpu)
+        {
+            std::vector<Uint8> pixels = {};
+            if (!SDLConvertTexturePixels(texture, pixels))
+            {
+                return nullptr;
+            }
+            SDLGenerateMipChain(pixels, width, height);
+            return SDLCreateTexture(width, height, pixels.data(), mipmaps, device, uploadQueue);
+        }
+
+        auto* gpuTexture = CreateRGBATexture(width, height, mipmaps, device);
+        if (gpuTexture == nullptr)
+        {
+            return nullptr;
+        }
 
-        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
-        SDL_UploadToGPUTexture(copyPass, &textureTransferInfo, &textureRegion, false);
-        SDL_EndGPUCopyPass(copyPass);
-        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        if (!SDLUploadTexture(gpuTexture, texture, uploadQueue))
+        {
+            SDL_ReleaseGPUTexture(device, gpuTexture);
+            return nullptr;
+        }
+
+        if (mipmaps == SDLMipmapMode::Gpu && SDLGetMipLevelCount(width, height) > 1)
+        {
+            uploadQueue.EnqueueMipmapGeneration(gpuTexture);
+        }
+        return gpuTexture;
     }
-    
-    SDL_Surface* SDLMakeSurface(const Tbx::Texture& texture)
+
+    SDL_GPUTexture* SDLCreateTexture(Uint32 width, Uint32 height, const Uint8* pixels, SDLMipmapMode mipmaps, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
     {
-        auto width = texture.GetWidth();
-        auto height = texture.GetHeight();
-        auto pixelData = (void*)texture.GetPixels().data();
-        auto pitch = texture.GetChannels() * width;
+        auto* gpuTexture = CreateRGBATexture(width, height, mipmaps, device);
+        if (gpuTexture == nullptr)
+        {
+            return nullptr;
+        }
 
-        // Convert tbx format to sdl pixel format
-        SDL_PixelFormat format;
-        switch (texture.GetFormat())
+        if (mipmaps == SDLMipmapMode::Cpu)
         {
-            case Tbx::TextureFormat::RGB:
-                format = SDL_PIXELFORMAT_RGB24;
-                break;
-            case Tbx::TextureFormat::RGBA:
-                format = SDL_PIXELFORMAT_RGBA32;
-                break;
-            default:
-                TBX_ASSERT(false, "Unsupported texture format!");
-                return nullptr;
+            UploadMipChain(gpuTexture, width, height, pixels, uploadQueue);
+            return gpuTexture;
+        }
+
+        uploadQueue.EnqueueTexture(gpuTexture, width * height * 4, pixels, width, height);
+        if (mipmaps == SDLMipmapMode::Gpu && SDLGetMipLevelCount(width, height) > 1)
+        {
+            uploadQueue.EnqueueMipmapGeneration(gpuTexture);
+        }
+        return gpuTexture;
+    }
+
+    SDL_GPUTexture* SDLCreateTexture(const SDLCompressedTexture& texture, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue)
+    {
+        if (SDLGetBlockBytes(texture.Format) == 0)
+        {
+            TBX_ASSERT(false, "Texture format {} isn't block compressed!", (int)texture.Format);
+            return nullptr;
         }
 
-        // Create surface from texture data
-        auto* surface = SDL_CreateSurfaceFrom(width, height, format, pixelData, pitch);
-        if (surface == nullptr)
+        SDL_GPUTextureCreateInfo info = {};
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.format = texture.Format;
+        info.width = texture.Width;
+        info.height = texture.Height;
+        info.layer_count_or_depth = 1;
+        info.num_levels = SDL_max(texture.LevelCount, 1u);
+        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        auto* gpuTexture = SDL_CreateGPUTexture(device, &info);
+        if (gpuTexture == nullptr)
         {
-            TBX_ASSERT("Failed to load BMP: {}", SDL_GetError());
             return nullptr;
         }
 
-        // Normalize to RGBA32 so upload format and data agree
-        if (surface->format != SDL_PIXELFORMAT_RGBA32)
+        size_t offset = 0;
+        for (Uint32 level = 0; level < info.num_levels; level++)
         {
-            SDL_Surface* converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
-            SDL_DestroySurface(surface);
-            surface = converted;
-            if (!surface)
+            const Uint32 levelWidth = SDL_max(texture.Width >> level, 1u);
+            const Uint32 levelHeight = SDL_max(texture.Height >> level, 1u);
+            const Uint32 levelSize = SDLGetCompressedLevelSize(texture.Format, levelWidth, levelHeight);
+            if (offset + levelSize > texture.Blocks.size())
             {
-                TBX_ASSERT(false, "Failed to convert surface: {}", SDL_GetError());
+                TBX_ASSERT(false, "Compressed texture is missing blocks for mip level {}!", level);
+                SDL_ReleaseGPUTexture(device, gpuTexture);
                 return nullptr;
             }
+
+            uploadQueue.EnqueueTexture(gpuTexture, levelSize, texture.Blocks.data() + offset, levelWidth, levelHeight, level);
+            offset += levelSize;
         }
 
-        return surface;
+        return gpuTexture;
     }
 
-    SDL_GPUSampler* SDLMakeSampler(const Tbx::Texture& texture, SDL_GPUDevice* device)
+    bool SDLUploadTexture(SDL_GPUTexture* texture, const Tbx::Texture& textureData, SDLUploadQueue& uploadQueue)
+    {
+        const auto width = static_cast<Uint32>(textureData.GetWidth());
+        const auto height = static_cast<Uint32>(textureData.GetHeight());
+        const size_t pixelCount = static_cast<size_t>(width) * height;
+        const auto& pixels = textureData.GetPixels();
+
+        const Tbx::TextureFormat format = textureData.GetFormat();
+        if (format != Tbx::TextureFormat::RGB && format != Tbx::TextureFormat::RGBA)
+        {
+            TBX_ASSERT(false, "Unsupported texture format!");
+            return false;
+        }
+
+        const size_t sourceChannels = format == Tbx::TextureFormat::RGB ? 3 : 4;
+        if (pixels.size() < pixelCount * sourceChannels)
+        {
+            TBX_ASSERT(false, "Texture has less pixel data than its size requires!");
+            return false;
+        }
+
+        // The copy is recorded later together with the rest of the frame's uploads,
+        // until then the pixels are written straight into the mapped transfer buffer
+        const auto uploadSize = static_cast<Uint32>(pixelCount * 4);
+        auto* destination = static_cast<Uint8*>(uploadQueue.EnqueueTexture(texture, uploadSize, width, height));
+        const auto* source = reinterpret_cast<const Uint8*>(pixels.data());
+        if (format == Tbx::TextureFormat::RGB)
+        {
+            SDLConvertRGBToRGBA(source, destination, pixelCount);
+        }
+        else
+        {
+            SDL_memcpy(destination, source, uploadSize);
+        }
+
+        return true;
+    }
+
+    SDL_GPUSamplerCreateInfo SDLMakeSamplerInfo(const Tbx::Texture& texture)
     {
         Tbx::TextureFilter textureFilter = texture.GetFilter();
         Tbx::TextureWrap textureWrap = texture.GetWrap();
@@ -187,6 +761,8 @@ namespace SDLRendering
         }
 
         samplerCreateInfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
+        samplerCreateInfo.min_lod = 0.0f;
+        samplerCreateInfo.max_lod = 1000.0f; // no clamp, textures without mips only have level 0 anyway
         switch (textureWrap)
         {
             case Tbx::TextureWrap::ClampToEdge:
@@ -205,7 +781,7 @@ namespace SDLRendering
                 samplerCreateInfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
                 break;
         }
-        
-        return SDL_CreateGPUSampler(device, &samplerCreateInfo);
+
+        return samplerCreateInfo;
     }
 }
@@ -1,21 +1,70 @@
 #pragma once
+#include "SDLTransfer.h"
+#include "SDLSampler.h"
+#include "SDLTextureStreamer.h"
+#include "SDLTextureDiskCache.h"
 #include <SDL3/SDL.h>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <Tbx/Graphics/Buffers.h>
 #include <Tbx/Graphics/Material.h>
 
 namespace SDLRendering
 {
+    // A 2D array texture shared by packed textures of the same size and mip count, each of them owns one layer
+    struct SDLTextureArray
+    {
+        SDLTextureArray() = default;
+        SDLTextureArray(SDL_GPUTexture* texture, Uint32 width, Uint32 height, Uint32 levelCount, Uint32 layerCount, SDL_GPUDevice* device);
+        ~SDLTextureArray();
+
+        // Returns false once every layer is taken
+        bool AllocateLayer(Uint32& layer);
+        void FreeLayer(Uint32 layer);
+        bool IsEmpty() const { return FreeLayers.size() == LayerCount; }
+
+        SDL_GPUTexture* Texture = nullptr;
+        SDL_GPUDevice* Device = nullptr;
+        Uint32 Width = 0;
+        Uint32 Height = 0;
+        Uint32 LevelCount = 0;
+        Uint32 LayerCount = 0;
+        std::vector<Uint32> FreeLayers = {};
+    };
+
     struct SDLCachedTexture
     {
         SDLCachedTexture() = default;
-        SDLCachedTexture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler, SDL_GPUDevice* device);
+        SDLCachedTexture(SDL_GPUTexture* texture, SDL_GPUSampler* sampler, SDLSamplerCache* samplerCache, SDL_GPUDevice* device);
         ~SDLCachedTexture();
 
         SDL_GPUTexture* Texture = nullptr;
+        // Shared with every texture using the same sampler state, the reference is handed back to the cache
         SDL_GPUSampler* Sampler = nullptr;
+        SDLSamplerCache* SamplerCache = nullptr;
         SDL_GPUDevice* Device = nullptr;
+
+        // Set for packed textures, Texture is then the shared array and the texture only owns its layer
+        SDLTextureArray* Array = nullptr;
+        Uint32 Layer = 0;
+
+        // Approximate GPU memory of all mip levels, and the last frame that bound or uploaded the texture
+        Uint64 Size = 0;
+        Uint64 LastUsedFrame = 0;
+    };
+
+    enum class SDLTextureResidency
+    {
+        // Never added to the cache
+        Missing,
+        // Being converted or waiting for upload budget, the placeholder is bound in its place
+        Streaming,
+        Resident
     };
 
     struct SDLTextureCache
@@ -23,20 +72,136 @@ namespace SDLRendering
     public:
         ~SDLTextureCache();
 
-        void Add(const Tbx::Texture& texture, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer);
+        // Creates the placeholders that are bound for textures that aren't resident, a 2D array one for textures
+        // that are to be packed so it matches what their shader samples
+        void Initialize(SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
+
+        // Uploads the texture, when streaming is on this only queues it for conversion
+        void Add(const Tbx::Texture& texture, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
+
+        // Returns the matching placeholder while the texture isn't resident
         const SDLCachedTexture& Get(const Tbx::Uid& texture);
 
+        // Takes the texture out of the cache, the GPU texture is released once the frames using it have completed
+        void Remove(const Tbx::Uid& texture);
+
+        // Advances the frame used for LRU tracking, releases textures retired at or before completedFrame
+        // and evicts the least recently used textures until the cache fits its memory budget again
+        void BeginFrame(Uint64 frame, Uint64 completedFrame);
+
+        // Bytes of texture memory the cache may hold, 0 is unlimited. Textures used by the previous frame are
+        // never evicted, so a frame that needs more than the budget goes over it rather than thrashing.
+        void SetMemoryBudget(Uint64 bytes);
+        Uint64 GetResidentBytes() const { return _residentBytes; }
+        Uint64 GetEvictionCount() const { return _evictionCount; }
+
+        // Pinned textures are never evicted, i.e. the fallback material's textures
+        void SetPinned(const Tbx::Uid& texture, bool pinned);
+
+        SDLTextureResidency GetResidency(const Tbx::Uid& texture) const;
+
+        // Converts textures on the given number of worker threads and spreads their uploads over frames,
+        // uploading at most bytesPerFrame each frame (0 is unlimited). 0 workers uploads inline in Add.
+        void SetStreaming(Uint32 workerCount, Uint32 bytesPerFrame);
+
+        // Uploads converted textures until this frame's byte budget is spent
+        void ProcessStreaming(SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
+
+        Uint32 GetStreamingCount() const;
+
+        // How mip chains are built for textures added from now on, unless a texture overrides it
+        void SetDefaultMipmapMode(SDLMipmapMode mode);
+
+        // Per texture override, i.e. None for UI or pixel art textures that are never minified
+        void SetMipmapMode(const Tbx::Uid& texture, SDLMipmapMode mode);
+        SDLMipmapMode GetMipmapMode(const Tbx::Uid& texture) const;
+
+        // Block compression for textures added from now on unless a texture overrides it, off by default.
+        // Textures are encoded on first use and the blocks persisted to the disk cache, keyed by their content.
+        void SetDefaultCompression(SDLTextureCompression compression);
+        void SetCompression(const Tbx::Uid& texture, SDLTextureCompression compression);
+        SDLTextureCompression GetCompression(const Tbx::Uid& texture) const;
+
+        // Encoded textures are persisted here so later runs can upload the blocks directly, an empty path disables it
+        void SetDiskCacheDirectory(const std::string& directory);
+
+        // Packs the texture into a 2D array texture shared with every other packed texture of the same size,
+        // so draws using any of them bind the same texture. Shaders sample it as an array at the texture's Layer.
+        // Packed textures are never compressed and build their mips on the CPU. Takes effect for textures added from now on.
+        // A texture that is to be packed is always bound as an array: one over the size limit gets a single layer array
+        // of its own, and one no array could be made for isn't cached, the array placeholder is bound in its place.
+        void SetArrayPacking(const Tbx::Uid& texture, bool packed);
+        bool GetArrayPacking(const Tbx::Uid& texture) const;
+
+        // True when the resident texture lives in a layer of an array, which is what its shader has to sample
+        bool IsPacked(const Tbx::Uid& texture) const;
+
+        // Textures bigger than maxSize on either side get arrays of their own, shared arrays are made with layerCount layers
+        void SetArrayPackingLimits(Uint32 maxSize, Uint32 layerCount);
+        Uint32 GetArrayCount() const { return static_cast<Uint32>(_textureArrays.size()); }
+
+        const SDLSamplerCache& GetSamplerCache() const { return _samplerCache; }
+
         void Clear();
 
     private:
-        std::unordered_map<Tbx::Uid, SDLCachedTexture> _cachedTextures;
+        using TextureMap = std::unordered_map<Tbx::Uid, SDLCachedTexture>;
+
+        // A texture that left the cache but may still be referenced by frames in flight
+        struct RetiredTexture
+        {
+            Uint64 Frame = 0;
+            TextureMap::node_type Node;
+        };
+
+        void Insert(const Tbx::Texture& texture, SDL_GPUTexture* gpuTexture, Uint64 size, SDL_GPUDevice* device, SDLTextureArray* array = nullptr, Uint32 layer = 0);
+        void Retire(TextureMap::iterator texture);
+
+        // Whether the texture fits into a shared array
+        bool IsPackable(const Tbx::Texture& texture) const;
+        bool AddPacked(const Tbx::Texture& texture, Uint32 width, Uint32 height, const std::vector<Uint8>& pixels, SDLMipmapMode mipmaps, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
+
+        // Declared first so they outlive the textures holding references into them
+        SDLSamplerCache _samplerCache;
+        std::vector<std::unique_ptr<SDLTextureArray>> _textureArrays;
+        TextureMap _cachedTextures;
+        std::vector<RetiredTexture> _retiredTextures;
+        std::unordered_set<Tbx::Uid> _pinnedTextures;
+        std::optional<SDLCachedTexture> _placeholder = std::nullopt;
+        std::optional<SDLCachedTexture> _arrayPlaceholder = std::nullopt;
+        SDLTextureStreamer _streamer;
+        std::unordered_set<Tbx::Uid> _streamingTextures;
+        std::deque<SDLTextureStreamResult> _streamedTextures;
+        std::unordered_map<Tbx::Uid, SDLMipmapMode> _mipmapModes;
+        std::unordered_map<Tbx::Uid, SDLTextureCompression> _compressionModes;
+        std::unordered_set<Tbx::Uid> _packedTextures;
+        SDLTextureDiskCache _diskCache;
+        SDLMipmapMode _defaultMipmapMode = SDLMipmapMode::Gpu;
+        SDLTextureCompression _defaultCompression = SDLTextureCompression::None;
+        Uint32 _streamingBudget = 0;
+        Uint32 _maxPackedSize = 256;
+        Uint32 _arrayLayerCount = 64;
+        Uint64 _memoryBudget = 0;
+        Uint64 _residentBytes = 0;
+        Uint64 _evictionCount = 0;
+        // Frames are counted from 1, uploads queued before the first frame are recorded by it
+        Uint64 _frameIndex = 1;
     };
 
-    SDL_Surface* SDLMakeSurface(const Tbx::Texture& texture);
+    // Describes the sampler state for the texture's filter and wrap, acquire it through an SDLSamplerCache
+    SDL_GPUSamplerCreateInfo SDLMakeSamplerInfo(const Tbx::Texture& texture);
+
+    SDL_GPUTexture* SDLCreateTexture(const Tbx::Texture& texture, SDLMipmapMode mipmaps, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
+
+    // Creates a texture from pixels that are already RGBA32, with CPU mipmaps the pixels hold the whole chain
+    SDL_GPUTexture* SDLCreateTexture(Uint32 width, Uint32 height, const Uint8* pixels, SDLMipmapMode mipmaps, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
 
-    SDL_GPUSampler* SDLMakeSampler(const Tbx::Texture& texture, SDL_GPUDevice* device);
+    // Creates a texture from pre-compressed blocks, any block format the device can sample (BC1-BC7) is accepted
+    SDL_GPUTexture* SDLCreateTexture(const SDLCompressedTexture& texture, SDL_GPUDevice* device, SDLUploadQueue& uploadQueue);
 
-    SDL_GPUTexture* SDLCreateTexture(const SDL_Surface* surface, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer);
+    // Creates an empty RGBA32 2D array texture for packed textures
+    SDL_GPUTexture* SDLCreateTextureArray(Uint32 width, Uint32 height, Uint32 levelCount, Uint32 layerCount, SDL_GPUDevice* device);
 
-    void SDLUploadTexture(SDL_GPUTexture* texture, Uint32 textureSize, const void* textureData, Uint32 textureWidth, Uint32 textureHeight, SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer);
+    // Writes the texture's pixels as RGBA32 straight into the upload queue's transfer memory, expanding RGB on the way
+    bool SDLUploadTexture(SDL_GPUTexture* texture, const Tbx::Texture& textureData, SDLUploadQueue& uploadQueue);
 }
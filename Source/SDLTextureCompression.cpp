@@ -0,0 +1,324 @@
+#include "SDLTextureCompression.h"
+#include "SDLTextureDiskCache.h"
+#include "SDLHash.h"
+#include "SDLTextureStreamer.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    static Uint16 PackRGB565(const Uint8* color)
+    {
+        return static_cast<Uint16>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    static void UnpackRGB565(Uint16 packed, int* color)
+    {
+        const int r = (packed >> 11) & 31;
+        const int g = (packed >> 5) & 63;
+        const int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    static void WriteUint16(Uint8* destination, Uint16 value)
+    {
+        destination[0] = static_cast<Uint8>(value & 0xFF);
+        destination[1] = static_cast<Uint8>(value >> 8);
+    }
+
+    // Reads the 4x4 block at (blockX, blockY) into 16 RGBA texels, clamping at the edges of the level
+    static void FetchBlock(const Uint8* pixels, Uint32 width, Uint32 height, Uint32 blockX, Uint32 blockY, Uint8* block)
+    {
+        for (Uint32 y = 0; y < 4; y++)
+        {
+            const Uint32 sourceY = SDL_min(blockY * 4 + y, height - 1);
+            for (Uint32 x = 0; x < 4; x++)
+            {
+                const Uint32 sourceX = SDL_min(blockX * 4 + x, width - 1);
+                SDL_memcpy(block + (y * 4 + x) * 4, pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+            }
+        }
+    }
+
+    // Bounding box endpoints inset by 1/16th of the range, then every texel picks the closest of the 4 palette colors
+    static void EncodeColorBlock(const Uint8* block, Uint8* destination)
+    {
+        Uint8 minColor[3] = { 255, 255, 255 };
+        Uint8 maxColor[3] = { 0, 0, 0 };
+        for (Uint32 i = 0; i < 16; i++)
+        {
+            for (Uint32 channel = 0; channel < 3; channel++)
+            {
+                minColor[channel] = SDL_min(minColor[channel], block[i * 4 + channel]);
+                maxColor[channel] = SDL_max(maxColor[channel], block[i * 4 + channel]);
+            }
+        }
+        for (Uint32 channel = 0; channel < 3; channel++)
+        {
+            const int inset = (maxColor[channel] - minColor[channel]) >> 4;
+            minColor[channel] = static_cast<Uint8>(SDL_min(minColor[channel] + inset, 255));
+            maxColor[channel] = static_cast<Uint8>(SDL_max(maxColor[channel] - inset, 0));
+        }
+
+        // c0 > c1 selects the 4 color mode
+        Uint16 color0 = PackRGB565(maxColor);
+        Uint16 color1 = PackRGB565(minColor);
+        if (color0 < color1)
+        {
+            const Uint16 swap = color0;
+            color0 = color1;
+            color1 = swap;
+        }
+
+        Uint32 indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][3] = {};
+            UnpackRGB565(color0, palette[0]);
+            UnpackRGB565(color1, palette[1]);
+            for (Uint32 channel = 0; channel < 3; channel++)
+            {
+                palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+                palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+            }
+
+            for (Uint32 i = 0; i < 16; i++)
+            {
+                Uint32 bestIndex = 0;
+                int bestDistance = SDL_MAX_SINT32;
+                for (Uint32 p = 0; p < 4; p++)
+                {
+                    const int dr = block[i * 4 + 0] - palette[p][0];
+                    const int dg = block[i * 4 + 1] - palette[p][1];
+                    const int db = block[i * 4 + 2] - palette[p][2];
+                    const int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+                indices |= bestIndex << (i * 2);
+            }
+        }
+
+        WriteUint16(destination, color0);
+        WriteUint16(destination + 2, color1);
+        destination[4] = static_cast<Uint8>(indices & 0xFF);
+        destination[5] = static_cast<Uint8>((indices >> 8) & 0xFF);
+        destination[6] = static_cast<Uint8>((indices >> 16) & 0xFF);
+        destination[7] = static_cast<Uint8>(indices >> 24);
+    }
+
+    // 8 alpha mode between the block's min and max alpha, 3 bit index per texel
+    static void EncodeAlphaBlock(const Uint8* block, Uint8* destination)
+    {
+        Uint8 minAlpha = 255;
+        Uint8 maxAlpha = 0;
+        for (Uint32 i = 0; i < 16; i++)
+        {
+            minAlpha = SDL_min(minAlpha, block[i * 4 + 3]);
+            maxAlpha = SDL_max(maxAlpha, block[i * 4 + 3]);
+        }
+
+        Uint64 indices = 0;
+        if (maxAlpha != minAlpha)
+        {
+            int palette[8] = { maxAlpha, minAlpha };
+            for (int p = 2; p < 8; p++)
+            {
+                palette[p] = ((8 - p) * maxAlpha + (p - 1) * minAlpha) / 7;
+            }
+
+            for (Uint32 i = 0; i < 16; i++)
+            {
+                Uint64 bestIndex = 0;
+                int bestDistance = SDL_MAX_SINT32;
+                for (Uint32 p = 0; p < 8; p++)
+                {
+                    const int distance = SDL_abs(block[i * 4 + 3] - palette[p]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+                indices |= bestIndex << (i * 3);
+            }
+        }
+
+        destination[0] = maxAlpha;
+        destination[1] = minAlpha;
+        for (Uint32 i = 0; i < 6; i++)
+        {
+            destination[2 + i] = static_cast<Uint8>((indices >> (i * 8)) & 0xFF);
+        }
+    }
+
+    Uint32 SDLGetBlockBytes(SDL_GPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+            case SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM:
+                return 8;
+            case SDL_GPU_TEXTUREFORMAT_BC2_RGBA_UNORM:
+            case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM:
+            case SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM:
+            case SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    Uint32 SDLGetCompressedLevelSize(SDL_GPUTextureFormat format, Uint32 width, Uint32 height)
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * SDLGetBlockBytes(format);
+    }
+
+    SDL_GPUTextureFormat SDLSelectCompressedFormat(const Tbx::Texture& texture, SDLTextureCompression compression, SDL_GPUDevice* device)
+    {
+        SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        switch (compression)
+        {
+            case SDLTextureCompression::Auto:
+                format = texture.GetFormat() == Tbx::TextureFormat::RGBA
+                    ? SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM
+                    : SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+                break;
+            case SDLTextureCompression::BC1:
+                format = SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+                break;
+            case SDLTextureCompression::BC3:
+                format = SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+                break;
+            default:
+                return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+
+        // Some backends reject block formats whose base level isn't made of whole blocks
+        if (texture.GetWidth() % 4 != 0 || texture.GetHeight() % 4 != 0)
+        {
+            return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+
+        if (!SDL_GPUTextureSupportsFormat(device, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER))
+        {
+            return SDL_GPU_TEXTUREFORMAT_INVALID;
+        }
+
+        return format;
+    }
+
+    bool SDLCompressTexture(const std::vector<Uint8>& pixels, Uint32 width, Uint32 height, Uint32 levelCount, SDL_GPUTextureFormat format, SDLCompressedTexture& compressed)
+    {
+        if (format != SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM && format != SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM)
+        {
+            TBX_TRACE_ERROR("Only BC1 and BC3 can be encoded, got format {}", (int)format);
+            return false;
+        }
+
+        compressed.Format = format;
+        compressed.Width = width;
+        compressed.Height = height;
+        compressed.LevelCount = levelCount;
+        compressed.Blocks.clear();
+
+        const bool hasAlpha = format == SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+        const Uint32 blockBytes = SDLGetBlockBytes(format);
+
+        size_t sourceOffset = 0;
+        for (Uint32 level = 0; level < levelCount; level++)
+        {
+            const Uint32 levelWidth = SDL_max(width >> level, 1u);
+            const Uint32 levelHeight = SDL_max(height >> level, 1u);
+            const Uint32 blocksX = (levelWidth + 3) / 4;
+            const Uint32 blocksY = (levelHeight + 3) / 4;
+
+            const size_t levelBytes = static_cast<size_t>(levelWidth) * levelHeight * 4;
+            if (sourceOffset + levelBytes > pixels.size())
+            {
+                TBX_TRACE_ERROR("Mip chain is smaller than its level count requires!");
+                return false;
+            }
+
+            size_t destinationOffset = compressed.Blocks.size();
+            compressed.Blocks.resize(destinationOffset + static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+            Uint8 block[64] = {};
+            for (Uint32 blockY = 0; blockY < blocksY; blockY++)
+            {
+                for (Uint32 blockX = 0; blockX < blocksX; blockX++)
+                {
+                    FetchBlock(pixels.data() + sourceOffset, levelWidth, levelHeight, blockX, blockY, block);
+
+                    Uint8* destination = compressed.Blocks.data() + destinationOffset;
+                    if (hasAlpha)
+                    {
+                        EncodeAlphaBlock(block, destination);
+                        destination += 8;
+                    }
+                    EncodeColorBlock(block, destination);
+                    destinationOffset += blockBytes;
+                }
+            }
+
+            sourceOffset += levelBytes;
+        }
+
+        return true;
+    }
+
+    Uint64 SDLHashTextureContent(const Tbx::Texture& texture, SDL_GPUTextureFormat format, SDLMipmapMode mipmaps)
+    {
+        const auto& pixels = texture.GetPixels();
+        const Uint32 settings[] =
+        {
+            static_cast<Uint32>(texture.GetWidth()),
+            static_cast<Uint32>(texture.GetHeight()),
+            static_cast<Uint32>(texture.GetFormat()),
+            static_cast<Uint32>(format),
+            static_cast<Uint32>(mipmaps)
+        };
+
+        const Uint64 hash = SDLHashBytes(pixels.data(), pixels.size() * sizeof(pixels[0]));
+        return SDLHashBytes(settings, sizeof(settings), hash);
+    }
+
+    bool SDLLoadOrCompressTexture(const Tbx::Texture& texture, SDL_GPUTextureFormat format, SDLMipmapMode mipmaps, SDLTextureDiskCache* diskCache, SDLCompressedTexture& compressed)
+    {
+        // Reuse the blocks from a previous run if the pixels didn't change, otherwise encode and persist them
+        // Block compressed textures can't be render targets, so their mips always come from the CPU
+        const auto width = static_cast<Uint32>(texture.GetWidth());
+        const auto height = static_cast<Uint32>(texture.GetHeight());
+        const Uint32 levelCount = mipmaps != SDLMipmapMode::None ? SDLGetMipLevelCount(width, height) : 1;
+        const Uint64 contentHash = SDLHashTextureContent(texture, format, mipmaps);
+        if (diskCache != nullptr && diskCache->Load(contentHash, format, width, height, levelCount, compressed))
+        {
+            return true;
+        }
+
+        std::vector<Uint8> pixels = {};
+        if (!SDLConvertTexturePixels(texture, pixels))
+        {
+            return false;
+        }
+        if (mipmaps != SDLMipmapMode::None)
+        {
+            SDLGenerateMipChain(pixels, width, height);
+        }
+
+        if (!SDLCompressTexture(pixels, width, height, levelCount, format, compressed))
+        {
+            return false;
+        }
+
+        if (diskCache != nullptr)
+        {
+            diskCache->Store(contentHash, compressed);
+        }
+        return true;
+    }
+}
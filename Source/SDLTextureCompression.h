@@ -0,0 +1,49 @@
+#pragma once
+#include "SDLPixelConversion.h"
+#include <SDL3/SDL.h>
+#include <vector>
+#include <Tbx/Graphics/Material.h>
+
+namespace SDLRendering
+{
+    struct SDLTextureDiskCache;
+
+    enum class SDLTextureCompression
+    {
+        // Uploaded as RGBA32
+        None,
+        // BC1 for RGB textures and BC3 for RGBA textures
+        Auto,
+        BC1,
+        BC3
+    };
+
+    // Block compressed pixels of a texture and all of its mip levels, tightly packed level after level
+    struct SDLCompressedTexture
+    {
+        SDL_GPUTextureFormat Format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        Uint32 Width = 0;
+        Uint32 Height = 0;
+        Uint32 LevelCount = 0;
+        std::vector<Uint8> Blocks = {};
+    };
+
+    // Bytes per 4x4 block, 0 if the format isn't block compressed
+    Uint32 SDLGetBlockBytes(SDL_GPUTextureFormat format);
+
+    Uint32 SDLGetCompressedLevelSize(SDL_GPUTextureFormat format, Uint32 width, Uint32 height);
+
+    // Picks the block format for the texture, or INVALID if it should stay uncompressed.
+    // Falls back to uncompressed if the device can't sample the format or the size isn't a multiple of the block size.
+    SDL_GPUTextureFormat SDLSelectCompressedFormat(const Tbx::Texture& texture, SDLTextureCompression compression, SDL_GPUDevice* device);
+
+    // Encodes an RGBA32 mip chain as laid out by SDLGenerateMipChain. Only BC1 and BC3 can be encoded,
+    // BC7 and the other block formats are accepted for upload but have to come pre-compressed.
+    bool SDLCompressTexture(const std::vector<Uint8>& pixels, Uint32 width, Uint32 height, Uint32 levelCount, SDL_GPUTextureFormat format, SDLCompressedTexture& compressed);
+
+    // Hashes the texture's pixels together with everything that changes the encoded result
+    Uint64 SDLHashTextureContent(const Tbx::Texture& texture, SDL_GPUTextureFormat format, SDLMipmapMode mipmaps);
+
+    // Returns the encoded texture from the disk cache if it is there, otherwise encodes and stores it
+    bool SDLLoadOrCompressTexture(const Tbx::Texture& texture, SDL_GPUTextureFormat format, SDLMipmapMode mipmaps, SDLTextureDiskCache* diskCache, SDLCompressedTexture& compressed);
+}
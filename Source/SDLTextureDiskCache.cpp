@@ -0,0 +1,68 @@
+#include "SDLTextureDiskCache.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    static constexpr Uint32 TextureCacheMagic = 0x54584254; // "TBXT"
+
+    // Bump whenever the block encoder changes its output
+    static constexpr Uint32 TextureEncoderVersion = 1;
+
+    struct SDLTextureCacheMetadata
+    {
+        Uint32 Format = 0;
+        Uint32 Width = 0;
+        Uint32 Height = 0;
+        Uint32 LevelCount = 0;
+    };
+
+    SDLTextureDiskCache::SDLTextureDiskCache()
+        : _cache("texture", ".tex", TextureCacheMagic, TextureEncoderVersion)
+    {
+    }
+
+    void SDLTextureDiskCache::SetDirectory(const std::string& directory)
+    {
+        _cache.SetDirectory(directory);
+    }
+
+    bool SDLTextureDiskCache::Load(Uint64 key, SDL_GPUTextureFormat format, Uint32 width, Uint32 height, Uint32 levelCount, SDLCompressedTexture& texture)
+    {
+        SDLTextureCacheMetadata metadata = {};
+        std::vector<Uint8> blocks = {};
+        if (!_cache.Load(key, blocks, &metadata, sizeof(metadata)))
+        {
+            return false;
+        }
+
+        // The blocks have to be exactly what the texture would be encoded to, whatever the key says
+        Uint64 expectedSize = 0;
+        for (Uint32 level = 0; level < levelCount; level++)
+        {
+            expectedSize += SDLGetCompressedLevelSize(format, SDL_max(width >> level, 1u), SDL_max(height >> level, 1u));
+        }
+        if (metadata.Format != static_cast<Uint32>(format) || metadata.Width != width || metadata.Height != height ||
+            metadata.LevelCount != levelCount || blocks.size() != expectedSize)
+        {
+            TBX_TRACE_WARN("Texture cache entry {:016x} doesn't match the texture asking for it, encoding it again", key);
+            return false;
+        }
+
+        texture.Format = format;
+        texture.Width = width;
+        texture.Height = height;
+        texture.LevelCount = levelCount;
+        texture.Blocks = std::move(blocks);
+        return true;
+    }
+
+    void SDLTextureDiskCache::Store(Uint64 key, const SDLCompressedTexture& texture)
+    {
+        SDLTextureCacheMetadata metadata = {};
+        metadata.Format = static_cast<Uint32>(texture.Format);
+        metadata.Width = texture.Width;
+        metadata.Height = texture.Height;
+        metadata.LevelCount = texture.LevelCount;
+        _cache.Store(key, texture.Blocks.data(), texture.Blocks.size(), &metadata, sizeof(metadata));
+    }
+}
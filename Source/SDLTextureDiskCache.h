@@ -0,0 +1,25 @@
+#pragma once
+#include "SDLDiskCache.h"
+#include "SDLTextureCompression.h"
+#include <SDL3/SDL.h>
+#include <string>
+
+namespace SDLRendering
+{
+    // Persists block compressed textures between runs, keyed by their content hash. Entries remember the format,
+    // size and mip count they were encoded with and only load for a texture asking for exactly that.
+    struct SDLTextureDiskCache
+    {
+    public:
+        SDLTextureDiskCache();
+
+        void SetDirectory(const std::string& directory);
+        const std::string& GetDirectory() const { return _cache.GetDirectory(); }
+
+        bool Load(Uint64 key, SDL_GPUTextureFormat format, Uint32 width, Uint32 height, Uint32 levelCount, SDLCompressedTexture& texture);
+        void Store(Uint64 key, const SDLCompressedTexture& texture);
+
+    private:
+        SDLDiskCache _cache;
+    };
+}
@@ -0,0 +1,63 @@
+#include "SDLTextureStreamer.h"
+#include "SDLPixelConversion.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    void SDLTextureStreamer::Start(Uint32 workerCount, SDLTextureDiskCache* diskCache)
+    {
+        _pool.Start(workerCount, [diskCache](SDLTextureStreamJob& job)
+        {
+            SDLTextureStreamResult result = {};
+            result.Width = static_cast<Uint32>(job.Texture.GetWidth());
+            result.Height = static_cast<Uint32>(job.Texture.GetHeight());
+            result.Mipmaps = job.Mipmaps;
+            if (job.CompressedFormat != SDL_GPU_TEXTUREFORMAT_INVALID)
+            {
+                result.Succeeded = SDLLoadOrCompressTexture(job.Texture, job.CompressedFormat, job.Mipmaps, diskCache, result.Compressed);
+            }
+            else
+            {
+                result.Succeeded = SDLConvertTexturePixels(job.Texture, result.Pixels);
+                if (result.Succeeded && result.Mipmaps == SDLMipmapMode::Cpu)
+                {
+                    SDLGenerateMipChain(result.Pixels, result.Width, result.Height);
+                }
+            }
+            result.Texture = std::move(job.Texture);
+            return result;
+        });
+    }
+
+    bool SDLConvertTexturePixels(const Tbx::Texture& texture, std::vector<Uint8>& pixels)
+    {
+        const auto pixelCount = static_cast<size_t>(texture.GetWidth()) * texture.GetHeight();
+        const auto& source = texture.GetPixels();
+
+        const Tbx::TextureFormat format = texture.GetFormat();
+        if (format != Tbx::TextureFormat::RGB && format != Tbx::TextureFormat::RGBA)
+        {
+            TBX_TRACE_ERROR("Unsupported texture format: {}", (int)format);
+            return false;
+        }
+
+        const size_t sourceChannels = format == Tbx::TextureFormat::RGB ? 3 : 4;
+        if (source.size() < pixelCount * sourceChannels)
+        {
+            TBX_TRACE_ERROR("Texture has less pixel data than its size requires!");
+            return false;
+        }
+
+        pixels.resize(pixelCount * 4);
+        const auto* sourcePixels = reinterpret_cast<const Uint8*>(source.data());
+        if (format == Tbx::TextureFormat::RGB)
+        {
+            SDLConvertRGBToRGBA(sourcePixels, pixels.data(), pixelCount);
+        }
+        else
+        {
+            SDL_memcpy(pixels.data(), sourcePixels, pixels.size());
+        }
+        return true;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "SDLPixelConversion.h"
+#include "SDLTextureCompression.h"
+#include "SDLWorkerPool.h"
+#include <SDL3/SDL.h>
+#include <deque>
+#include <vector>
+#include <Tbx/Graphics/Material.h>
+
+namespace SDLRendering
+{
+    struct SDLTextureStreamJob
+    {
+        // A copy, the caller's texture may be gone by the time a worker gets to it
+        Tbx::Texture Texture;
+        SDLMipmapMode Mipmaps = SDLMipmapMode::None;
+
+        // Block compresses the texture into this format when valid
+        SDL_GPUTextureFormat CompressedFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+    };
+
+    struct SDLTextureStreamResult
+    {
+        Tbx::Texture Texture;
+        SDLMipmapMode Mipmaps = SDLMipmapMode::None;
+
+        // RGBA32, holds the whole mip chain when the CPU generates it. Empty for compressed textures.
+        std::vector<Uint8> Pixels = {};
+        SDLCompressedTexture Compressed = {};
+        Uint32 Width = 0;
+        Uint32 Height = 0;
+        bool Succeeded = false;
+    };
+
+    // Converts texture pixels to RGBA32, builds CPU mip chains and block compresses on a worker pool in the background.
+    // Only the conversion runs on the workers, the GPU textures are created and uploaded on the render thread.
+    struct SDLTextureStreamer
+    {
+    public:
+        void Start(Uint32 workerCount, SDLTextureDiskCache* diskCache);
+        void Stop() { _pool.Stop(); }
+        bool IsRunning() const { return _pool.IsRunning(); }
+
+        void Enqueue(SDLTextureStreamJob job) { _pool.Enqueue(std::move(job)); }
+
+        // Moves every finished result into the given list
+        void TakeCompleted(std::deque<SDLTextureStreamResult>& results) { _pool.TakeCompleted(results); }
+
+        // Jobs that are queued or being converted right now
+        Uint32 GetPendingCount() const { return _pool.GetPendingCount(); }
+
+    private:
+        SDLWorkerPool<SDLTextureStreamJob, SDLTextureStreamResult> _pool;
+    };
+
+    // Converts the texture's pixels to tightly packed RGBA32, returns false for unsupported formats
+    bool SDLConvertTexturePixels(const Tbx::Texture& texture, std::vector<Uint8>& pixels);
+}
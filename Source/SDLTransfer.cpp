@@ -0,0 +1,242 @@
+#include "SDLTransfer.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    SDLTransferAllocator::~SDLTransferAllocator()
+    {
+        Clear();
+    }
+
+    void SDLTransferAllocator::Initialize(SDL_GPUDevice* device, Uint32 framesInFlight, Uint32 initialSize)
+    {
+        Clear();
+
+        _device = device;
+        _frames.resize(framesInFlight > 0 ? framesInFlight : 1);
+        for (auto& frame : _frames)
+        {
+            Grow(frame, initialSize);
+        }
+        _currentFrame = 0;
+        _cycleOnMap = true;
+    }
+
+    void SDLTransferAllocator::BeginFrame()
+    {
+        Unmap();
+
+        _currentFrame = (_currentFrame + 1) % static_cast<Uint32>(_frames.size());
+        auto& frame = _frames[_currentFrame];
+        frame.Head = 0;
+        for (auto* retired : frame.Retired)
+        {
+            SDL_ReleaseGPUTransferBuffer(_device, retired);
+        }
+        frame.Retired.clear();
+
+        // The GPU may still be reading what was written to this buffer frames ago,
+        // so the first map of the frame lets SDL cycle to an unused backing buffer.
+        _cycleOnMap = true;
+    }
+
+    SDLTransferAllocation SDLTransferAllocator::Allocate(Uint32 size, Uint32 alignment)
+    {
+        TBX_ASSERT(!_frames.empty(), "Transfer allocator used before it was initialized!");
+
+        auto& frame = _frames[_currentFrame];
+        Uint32 offset = (frame.Head + alignment - 1) & ~(alignment - 1);
+        if (offset + size > frame.Capacity)
+        {
+            // Out of space, swap in a bigger buffer for this frame.
+            // Allocations handed out earlier keep referencing the old buffer, which is retired until the slot is reused.
+            Unmap();
+            Grow(frame, SDL_max(frame.Capacity * 2, size));
+            offset = 0;
+        }
+
+        if (_mappedData == nullptr)
+        {
+            _mappedData = static_cast<Uint8*>(SDL_MapGPUTransferBuffer(_device, frame.TransferBuffer, _cycleOnMap));
+            TBX_ASSERT(_mappedData != nullptr, "Failed to map transfer buffer: {}", SDL_GetError());
+            _cycleOnMap = false;
+        }
+
+        frame.Head = offset + size;
+
+        SDLTransferAllocation allocation = {};
+        allocation.TransferBuffer = frame.TransferBuffer;
+        allocation.Offset = offset;
+        allocation.Data = _mappedData + offset;
+        return allocation;
+    }
+
+    void SDLTransferAllocator::Unmap()
+    {
+        if (_mappedData != nullptr)
+        {
+            SDL_UnmapGPUTransferBuffer(_device, _frames[_currentFrame].TransferBuffer);
+            _mappedData = nullptr;
+        }
+    }
+
+    void SDLTransferAllocator::Clear()
+    {
+        Unmap();
+
+        for (auto& frame : _frames)
+        {
+            if (frame.TransferBuffer != nullptr)
+            {
+                SDL_ReleaseGPUTransferBuffer(_device, frame.TransferBuffer);
+                frame.TransferBuffer = nullptr;
+            }
+            for (auto* retired : frame.Retired)
+            {
+                SDL_ReleaseGPUTransferBuffer(_device, retired);
+            }
+            frame.Retired.clear();
+        }
+        _frames.clear();
+    }
+
+    Uint32 SDLTransferAllocator::GetUsedBytes() const
+    {
+        return _frames.empty() ? 0 : _frames[_currentFrame].Head;
+    }
+
+    Uint32 SDLTransferAllocator::GetCapacity() const
+    {
+        return _frames.empty() ? 0 : _frames[_currentFrame].Capacity;
+    }
+
+    void SDLTransferAllocator::Grow(Frame& frame, Uint32 minSize)
+    {
+        if (frame.TransferBuffer != nullptr)
+        {
+            frame.Retired.push_back(frame.TransferBuffer);
+            frame.TransferBuffer = nullptr;
+        }
+
+        SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {};
+        transferBufferCreateInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        transferBufferCreateInfo.size = minSize;
+        frame.TransferBuffer = SDL_CreateGPUTransferBuffer(_device, &transferBufferCreateInfo);
+        TBX_ASSERT(frame.TransferBuffer != nullptr, "Failed to create transfer buffer: {}", SDL_GetError());
+
+        frame.Capacity = minSize;
+        frame.Head = 0;
+    }
+
+    void SDLUploadQueue::Initialize(SDL_GPUDevice* device, Uint32 framesInFlight, Uint32 initialSize)
+    {
+        Clear();
+        _allocator.Initialize(device, framesInFlight, initialSize);
+    }
+
+    void SDLUploadQueue::BeginFrame()
+    {
+        _allocator.BeginFrame();
+    }
+
+    void SDLUploadQueue::EnqueueBuffer(SDL_GPUBuffer* buffer, Uint32 size, const void* data)
+    {
+        SDLTransferAllocation allocation = _allocator.Allocate(size);
+        SDL_memcpy(allocation.Data, data, size);
+
+        BufferUpload upload = {};
+        upload.Source.transfer_buffer = allocation.TransferBuffer;
+        upload.Source.offset = allocation.Offset;
+        upload.Destination.buffer = buffer;
+        upload.Destination.offset = 0;
+        upload.Destination.size = size;
+        _bufferUploads.push_back(upload);
+
+        _pendingBytes += size;
+    }
+
+    void SDLUploadQueue::EnqueueTexture(SDL_GPUTexture* texture, Uint32 size, const void* data, Uint32 width, Uint32 height, Uint32 mipLevel, Uint32 layer)
+    {
+        void* destination = EnqueueTexture(texture, size, width, height, mipLevel, layer);
+        SDL_memcpy(destination, data, size);
+    }
+
+    void* SDLUploadQueue::EnqueueTexture(SDL_GPUTexture* texture, Uint32 size, Uint32 width, Uint32 height, Uint32 mipLevel, Uint32 layer)
+    {
+        SDLTransferAllocation allocation = _allocator.Allocate(size);
+
+        TextureUpload upload = {};
+        upload.Source.transfer_buffer = allocation.TransferBuffer;
+        upload.Source.offset = allocation.Offset;
+        upload.Destination.texture = texture;
+        upload.Destination.mip_level = mipLevel;
+        upload.Destination.layer = layer;
+        upload.Destination.w = width;
+        upload.Destination.h = height;
+        upload.Destination.d = 1;
+        _textureUploads.push_back(upload);
+
+        _pendingBytes += size;
+        return allocation.Data;
+    }
+
+    void SDLUploadQueue::EnqueueMipmapGeneration(SDL_GPUTexture* texture)
+    {
+        _mipmapGenerations.push_back(texture);
+    }
+
+    bool SDLUploadQueue::Submit(SDL_GPUCommandBuffer* commandBuffer)
+    {
+        if (!HasPending())
+        {
+            return false;
+        }
+
+        // Copies can only read from unmapped transfer buffers
+        _allocator.Unmap();
+
+        const bool hasCopies = !_bufferUploads.empty() || !_textureUploads.empty();
+        if (hasCopies)
+        {
+            SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+            for (const auto& upload : _bufferUploads)
+            {
+                SDL_UploadToGPUBuffer(copyPass, &upload.Source, &upload.Destination, true);
+            }
+            for (const auto& upload : _textureUploads)
+            {
+                SDL_UploadToGPUTexture(copyPass, &upload.Source, &upload.Destination, false);
+            }
+            SDL_EndGPUCopyPass(copyPass);
+        }
+
+        // Mip generation blits from the freshly uploaded base levels, so it has to come after the copy pass
+        for (auto* texture : _mipmapGenerations)
+        {
+            SDL_GenerateMipmapsForGPUTexture(commandBuffer, texture);
+        }
+
+        _submittedBytes += _pendingBytes;
+        _submittedTextureUploads += _textureUploads.size();
+
+        _bufferUploads.clear();
+        _textureUploads.clear();
+        _mipmapGenerations.clear();
+        _pendingBytes = 0;
+        return hasCopies;
+    }
+
+    bool SDLUploadQueue::HasPending() const
+    {
+        return !_bufferUploads.empty() || !_textureUploads.empty() || !_mipmapGenerations.empty();
+    }
+
+    void SDLUploadQueue::Clear()
+    {
+        _bufferUploads.clear();
+        _textureUploads.clear();
+        _mipmapGenerations.clear();
+        _pendingBytes = 0;
+        _allocator.Clear();
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+
+namespace SDLRendering
+{
+    struct SDLTransferAllocation
+    {
+        SDL_GPUTransferBuffer* TransferBuffer = nullptr;
+        Uint32 Offset = 0;
+        void* Data = nullptr;
+    };
+
+    // Hands out ranges of one large upload transfer buffer per frame in flight.
+    // Ranges are bump allocated so small uploads share a mapping and no driver objects are created per upload,
+    // when a frame runs out of space its buffer is replaced by a bigger one.
+    struct SDLTransferAllocator
+    {
+    public:
+        ~SDLTransferAllocator();
+
+        void Initialize(SDL_GPUDevice* device, Uint32 framesInFlight, Uint32 initialSize);
+
+        // Moves on to the next frame's transfer buffer and resets its head
+        void BeginFrame();
+
+        // Returns a mapped, aligned range of the current frame's transfer buffer
+        SDLTransferAllocation Allocate(Uint32 size, Uint32 alignment = 16);
+
+        // Must be called before any copy command reading from an allocation is recorded
+        void Unmap();
+
+        void Clear();
+
+        Uint32 GetUsedBytes() const;
+        Uint32 GetCapacity() const;
+
+    private:
+        struct Frame
+        {
+            SDL_GPUTransferBuffer* TransferBuffer = nullptr;
+            Uint32 Capacity = 0;
+            Uint32 Head = 0;
+
+            // Buffers replaced by a grow, kept alive until this frame slot comes around again
+            std::vector<SDL_GPUTransferBuffer*> Retired = {};
+        };
+
+        void Grow(Frame& frame, Uint32 minSize);
+
+        std::vector<Frame> _frames = {};
+        SDL_GPUDevice* _device = nullptr;
+        Uint32 _currentFrame = 0;
+        Uint8* _mappedData = nullptr;
+        bool _cycleOnMap = true;
+    };
+
+    // Collects every buffer and texture upload of a frame so they can be recorded into a single copy pass
+    struct SDLUploadQueue
+    {
+    public:
+        void Initialize(SDL_GPUDevice* device, Uint32 framesInFlight, Uint32 initialSize);
+        void BeginFrame();
+
+        void EnqueueBuffer(SDL_GPUBuffer* buffer, Uint32 size, const void* data);
+        void EnqueueTexture(SDL_GPUTexture* texture, Uint32 size, const void* data, Uint32 width, Uint32 height, Uint32 mipLevel = 0, Uint32 layer = 0);
+
+        // Queues a texture upload and returns the mapped transfer memory for the caller to fill in,
+        // so pixels can be written straight into it instead of being copied from a staging copy
+        void* EnqueueTexture(SDL_GPUTexture* texture, Uint32 size, Uint32 width, Uint32 height, Uint32 mipLevel = 0, Uint32 layer = 0);
+
+        // Generates the texture's mip chain from its base level right after the copy pass, the texture needs COLOR_TARGET usage
+        void EnqueueMipmapGeneration(SDL_GPUTexture* texture);
+
+        // Records all pending uploads into one copy pass followed by the queued mip generation,
+        // returns false if no copy pass was needed
+        bool Submit(SDL_GPUCommandBuffer* commandBuffer);
+
+        bool HasPending() const;
+        Uint64 GetPendingBytes() const { return _pendingBytes; }
+
+        // Running totals of what Submit recorded, texture uploads count one per mip level and layer
+        Uint64 GetSubmittedBytes() const { return _submittedBytes; }
+        Uint64 GetSubmittedTextureUploads() const { return _submittedTextureUploads; }
+
+        void Clear();
+
+    private:
+        struct BufferUpload
+        {
+            SDL_GPUTransferBufferLocation Source = {};
+            SDL_GPUBufferRegion Destination = {};
+        };
+
+        struct TextureUpload
+        {
+            SDL_GPUTextureTransferInfo Source = {};
+            SDL_GPUTextureRegion Destination = {};
+        };
+
+        SDLTransferAllocator _allocator = {};
+        std::vector<BufferUpload> _bufferUploads = {};
+        std::vector<TextureUpload> _textureUploads = {};
+        std::vector<SDL_GPUTexture*> _mipmapGenerations = {};
+        Uint64 _pendingBytes = 0;
+        Uint64 _submittedBytes = 0;
+        Uint64 _submittedTextureUploads = 0;
+    };
+}
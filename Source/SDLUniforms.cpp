@@ -0,0 +1,216 @@
+#include "SDLUniforms.h"
+#include "SDLShader.h"
+#include "SDLHash.h"
+#include <Tbx/Debug/Debugging.h>
+
+namespace SDLRendering
+{
+    SDLUniformArena::~SDLUniformArena()
+    {
+        Clear();
+    }
+
+    void SDLUniformArena::SetStorageThreshold(Uint32 size)
+    {
+        _storageThreshold = size;
+
+        // Force the next Stage to reassign the blocks
+        _stagedVersion = 0;
+        _storageAssignments.clear();
+    }
+
+    void SDLUniformArena::Stage(const SDLCommandList& commandList, SDLBufferPool& bufferPool, SDLUploadQueue& uploadQueue)
+    {
+        if (commandList.GetVersion() == _stagedVersion)
+        {
+            return;
+        }
+        _stagedVersion = commandList.GetVersion();
+
+        const auto& uniforms = commandList.GetUniforms();
+        _storageAssignments.assign(uniforms.size(), nullptr);
+        _storageContents.clear();
+        if (_storageThreshold == 0)
+        {
+            return;
+        }
+
+        Uint32 usedBuffers = 0;
+        for (size_t i = 0; i < uniforms.size(); i++)
+        {
+            const auto& uniform = uniforms[i];
+            if (uniform.Size <= _storageThreshold)
+            {
+                continue;
+            }
+
+            // Identical blocks share one buffer
+            const Uint8* data = commandList.GetUniformData(uniform);
+            const Uint64 contentKey = SDLHashBytes(data, uniform.Size);
+            const auto [first, last] = _storageContents.equal_range(contentKey);
+            for (auto existing = first; existing != last; ++existing)
+            {
+                const auto& other = uniforms[existing->second];
+                if (other.Size == uniform.Size && SDL_memcmp(commandList.GetUniformData(other), data, uniform.Size) == 0)
+                {
+                    _storageAssignments[i] = _storageAssignments[existing->second];
+                    break;
+                }
+            }
+            if (_storageAssignments[i] != nullptr)
+            {
+                continue;
+            }
+
+            if (usedBuffers == _storageBuffers.size())
+            {
+                _storageBuffers.emplace_back();
+            }
+
+            SDLPooledBuffer& storageBuffer = _storageBuffers[usedBuffers++];
+            if (storageBuffer.Buffer == nullptr || storageBuffer.Size < uniform.Size)
+            {
+                bufferPool.Release(storageBuffer);
+                storageBuffer = bufferPool.Acquire(SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, uniform.Size);
+                _bufferPool = &bufferPool;
+            }
+
+            SDLUploadBuffer(storageBuffer.Buffer, uniform.Size, data, uploadQueue);
+            _storageAssignments[i] = storageBuffer.Buffer;
+            _storageContents.emplace(contentKey, i);
+        }
+    }
+
+    void SDLUniformArena::ShareStorage(const SDLUniformArena& stagedArena)
+    {
+        _storageAssignments = stagedArena._storageAssignments;
+    }
+
+    void SDLUniformArena::Reset()
+    {
+        for (auto& stage : _slots)
+        {
+            for (auto& slot : stage)
+            {
+                slot = {};
+            }
+        }
+        _pushCount = 0;
+        _skippedCount = 0;
+    }
+
+    void SDLUniformArena::ResetBindings()
+    {
+        for (auto& stage : _slots)
+        {
+            for (auto& slot : stage)
+            {
+                slot.BoundStorage = nullptr;
+                if (slot.Storage != nullptr)
+                {
+                    slot.Dirty = true;
+                }
+            }
+        }
+    }
+
+    void SDLUniformArena::Set(Uint32 uniform, const SDLCommandList& commandList)
+    {
+        const auto& shaderData = commandList.GetUniforms()[uniform];
+        if (shaderData.Slot >= MaxSlots)
+        {
+            TBX_ASSERT(false, "Uniform slot {} is out of range!", shaderData.Slot);
+            return;
+        }
+
+        Slot& slot = _slots[shaderData.IsFragment ? 1 : 0][shaderData.Slot];
+        slot.Data = commandList.GetUniformData(shaderData);
+        slot.Size = shaderData.Size;
+        slot.Storage = uniform < _storageAssignments.size() ? _storageAssignments[uniform] : nullptr;
+
+        // Only dirty the slot if the command buffer doesn't already hold these bytes
+        bool unchanged = false;
+        if (slot.Storage != nullptr)
+        {
+            unchanged = slot.Storage == slot.BoundStorage;
+        }
+        else
+        {
+            unchanged = slot.PushedData != nullptr && slot.PushedSize == slot.Size &&
+                (slot.PushedData == slot.Data || SDL_memcmp(slot.PushedData, slot.Data, slot.Size) == 0);
+        }
+
+        slot.Dirty = !unchanged;
+        if (unchanged)
+        {
+            _skippedCount++;
+        }
+    }
+
+    void SDLUniformArena::Flush(SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass, const SDLShaderBindings& vertexBindings, const SDLShaderBindings& fragmentBindings)
+    {
+        for (Uint32 stage = 0; stage < 2; stage++)
+        {
+            const bool isFragment = stage == 1;
+            const SDLShaderBindings& bindings = isFragment ? fragmentBindings : vertexBindings;
+            for (Uint32 i = 0; i < MaxSlots; i++)
+            {
+                Slot& slot = _slots[stage][i];
+                if (!slot.Dirty)
+                {
+                    continue;
+                }
+
+                // Slots the shader doesn't declare stay dirty until one that does is bound
+                if (slot.Storage != nullptr && i < bindings.NumStorageBuffers)
+                {
+                    if (isFragment)
+                    {
+                        SDL_BindGPUFragmentStorageBuffers(renderPass, i, &slot.Storage, 1);
+                    }
+                    else
+                    {
+                        SDL_BindGPUVertexStorageBuffers(renderPass, i, &slot.Storage, 1);
+                    }
+                    slot.BoundStorage = slot.Storage;
+                }
+                else if (slot.Data != nullptr && i < bindings.NumUniformBuffers)
+                {
+                    if (isFragment)
+                    {
+                        SDL_PushGPUFragmentUniformData(commandBuffer, i, slot.Data, slot.Size);
+                    }
+                    else
+                    {
+                        SDL_PushGPUVertexUniformData(commandBuffer, i, slot.Data, slot.Size);
+                    }
+                    slot.PushedData = slot.Data;
+                    slot.PushedSize = slot.Size;
+                }
+                else
+                {
+                    continue;
+                }
+
+                slot.Dirty = false;
+                _pushCount++;
+            }
+        }
+    }
+
+    void SDLUniformArena::Clear()
+    {
+        for (const auto& storageBuffer : _storageBuffers)
+        {
+            if (storageBuffer.Buffer != nullptr)
+            {
+                _bufferPool->Release(storageBuffer);
+            }
+        }
+        _storageBuffers.clear();
+        _storageAssignments.clear();
+        _storageContents.clear();
+        _stagedVersion = 0;
+        Reset();
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "SDLTransfer.h"
+#include "SDLCommandList.h"
+#include "SDLShaderCompiler.h"
+#include "SDLBufferPool.h"
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <vector>
+
+namespace SDLRendering
+{
+    // Tracks the uniform data each slot of each stage holds on the current command buffer.
+    // Uniform bytes are referenced straight from the command list's arena, which already holds them for the frame,
+    // setting a uniform only marks its slot dirty if the bytes differ from what was last pushed, and Flush
+    // pushes nothing but the dirty slots the bound shaders declare.
+    // Blocks larger than the storage threshold can be uploaded into storage buffers instead, a block set on
+    // uniform slot N is then bound to storage buffer slot N if the shader declares one there.
+    struct SDLUniformArena
+    {
+    public:
+        // SDL GPU exposes this many uniform slots per stage
+        static constexpr Uint32 MaxSlots = 4;
+
+        ~SDLUniformArena();
+
+        // Blocks bigger than this many bytes go through storage buffers, 0 pushes everything as uniforms
+        void SetStorageThreshold(Uint32 size);
+        Uint32 GetStorageThreshold() const { return _storageThreshold; }
+
+        // Uploads the blocks above the storage threshold, must happen before the frame's uploads are submitted.
+        // Skipped if the command list didn't change since the last call, the buffers then still hold the data.
+        void Stage(const SDLCommandList& commandList, SDLBufferPool& bufferPool, SDLUploadQueue& uploadQueue);
+
+        // Uses the storage buffers the given arena staged, for arenas recording other command buffers of the same frame
+        void ShareStorage(const SDLUniformArena& stagedArena);
+
+        // Forgets what was pushed, must be called for every new command buffer
+        void Reset();
+
+        // Storage buffer bindings don't outlive a render pass, must be called for every new render pass
+        void ResetBindings();
+
+        // Makes the uniform the current value of its slot
+        void Set(Uint32 uniform, const SDLCommandList& commandList);
+
+        // Pushes or binds every dirty slot the shaders read
+        void Flush(SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass, const SDLShaderBindings& vertexBindings, const SDLShaderBindings& fragmentBindings);
+
+        void Clear();
+
+        // Slots pushed or bound, and sets that were skipped because the slot already held the data, since the last Reset
+        Uint32 GetPushCount() const { return _pushCount; }
+        Uint32 GetSkippedCount() const { return _skippedCount; }
+
+    private:
+        struct Slot
+        {
+            const Uint8* Data = nullptr;
+            Uint32 Size = 0;
+            SDL_GPUBuffer* Storage = nullptr;
+
+            const Uint8* PushedData = nullptr;
+            Uint32 PushedSize = 0;
+            SDL_GPUBuffer* BoundStorage = nullptr;
+
+            bool Dirty = false;
+        };
+
+        // [0] is the vertex stage, [1] the fragment stage
+        Slot _slots[2][MaxSlots] = {};
+
+        std::vector<SDLPooledBuffer> _storageBuffers = {};
+        std::vector<SDL_GPUBuffer*> _storageAssignments = {};
+        // Content hash to the index of the first uniform uploaded with those bytes, hits are confirmed by comparing them
+        std::unordered_multimap<Uint64, size_t> _storageContents = {};
+
+        SDLBufferPool* _bufferPool = nullptr;
+        Uint32 _storageThreshold = 0;
+        Uint64 _stagedVersion = 0;
+        Uint32 _pushCount = 0;
+        Uint32 _skippedCount = 0;
+    };
+}
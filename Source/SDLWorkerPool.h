@@ -0,0 +1,120 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SDLRendering
+{
+    // A pool of worker threads turning queued jobs into results in the background.
+    // Jobs are taken in the order they were queued, results are collected with TakeCompleted in the order they finished.
+    template <typename Job, typename Result>
+    struct SDLWorkerPool
+    {
+    public:
+        using Process = std::function<Result(Job&)>;
+
+        ~SDLWorkerPool()
+        {
+            Stop();
+        }
+
+        // Restarts the pool with workerCount workers (at least one) running process on every job
+        void Start(Uint32 workerCount, Process process)
+        {
+            Stop();
+
+            _process = std::move(process);
+            _stopping = false;
+            for (Uint32 i = 0; i < SDL_max(workerCount, 1u); i++)
+            {
+                _workers.emplace_back([this]() { WorkerLoop(); });
+            }
+        }
+
+        // Drops the jobs still queued and waits for the ones being worked on, their results can still be taken
+        void Stop()
+        {
+            {
+                std::lock_guard lock(_jobsMutex);
+                _stopping = true;
+                _pendingCount -= static_cast<Uint32>(_jobs.size());
+                _jobs.clear();
+            }
+            _jobsAvailable.notify_all();
+
+            for (auto& worker : _workers)
+            {
+                worker.join();
+            }
+            _workers.clear();
+        }
+
+        bool IsRunning() const { return !_workers.empty(); }
+
+        void Enqueue(Job job)
+        {
+            {
+                std::lock_guard lock(_jobsMutex);
+                _jobs.push_back(std::move(job));
+                _pendingCount++;
+            }
+            _jobsAvailable.notify_one();
+        }
+
+        // Moves every finished result to the back of the given container
+        template <typename Container>
+        void TakeCompleted(Container& results)
+        {
+            std::lock_guard lock(_completedMutex);
+            for (auto& result : _completed)
+            {
+                results.push_back(std::move(result));
+            }
+            _completed.clear();
+        }
+
+        // Jobs that are queued or being worked on right now
+        Uint32 GetPendingCount() const { return _pendingCount.load(); }
+
+    private:
+        void WorkerLoop()
+        {
+            while (true)
+            {
+                Job job = {};
+                {
+                    std::unique_lock lock(_jobsMutex);
+                    _jobsAvailable.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+                    if (_stopping)
+                    {
+                        return;
+                    }
+                    job = std::move(_jobs.front());
+                    _jobs.pop_front();
+                }
+
+                Result result = _process(job);
+                {
+                    std::lock_guard lock(_completedMutex);
+                    _completed.push_back(std::move(result));
+                }
+                _pendingCount--;
+            }
+        }
+
+        std::vector<std::thread> _workers = {};
+        std::deque<Job> _jobs = {};
+        std::vector<Result> _completed = {};
+        std::mutex _jobsMutex;
+        std::mutex _completedMutex;
+        std::condition_variable _jobsAvailable;
+        std::atomic<Uint32> _pendingCount = 0;
+        Process _process = nullptr;
+        bool _stopping = false;
+    };
+}
@@ -1,3 +1,9 @@
+newoption
+{
+    trigger = "sdl-rendering-benchmarks",
+    description = "Also generate the SDL3 Rendering micro-benchmark executables"
+}
+
 project "SDL3 Rendering"
     kind "SharedLib"
     language "C++"
@@ -21,6 +27,10 @@ project "SDL3 Rendering"
         "./**.md",
         "./**.plugin"
     }
+    removefiles
+    {
+        "./Benchmarks/**"
+    }
     includedirs
     {
         "./Source",
@@ -34,3 +44,48 @@ project "SDL3 Rendering"
         "SDL3_shadercross",
         "dxcompiler"
     }
+
+if _OPTIONS["sdl-rendering-benchmarks"] then
+    project "SDL3 Rendering Pixel Conversion Bench"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+        staticruntime "Off"
+        optimize "Speed"
+
+        files
+        {
+            "./Benchmarks/PixelConversionBench.cpp",
+            "./Source/SDLPixelConversion.h",
+            "./Source/SDLPixelConversion.cpp"
+        }
+        includedirs
+        {
+            "./Source",
+            _MAIN_SCRIPT_DIR .. "/Dependencies/SDL/include"
+        }
+        links
+        {
+            "SDL3"
+        }
+
+    project "SDL3 Rendering Parallel Blit Bench"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+        staticruntime "Off"
+        optimize "Speed"
+
+        files
+        {
+            "./Benchmarks/ParallelBlitBench.cpp"
+        }
+        includedirs
+        {
+            _MAIN_SCRIPT_DIR .. "/Dependencies/SDL/include"
+        }
+        links
+        {
+            "SDL3"
+        }
+end